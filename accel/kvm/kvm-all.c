@@ -39,6 +39,7 @@
 #include "exec/tswap.h"
 #include "exec/target_page.h"
 #include "system/memory.h"
+#include "system/ioport.h"
 #include "qemu/event_notifier.h"
 #include "qemu/main-loop.h"
 #include "trace.h"
@@ -3133,9 +3134,22 @@ static void kvm_handle_io(uint16_t port, MemTxAttrs attrs, void *data, int direc
     uint8_t *ptr = data;
 
     for (i = 0; i < count; i++) {
-        address_space_rw(&address_space_io, port, attrs,
-                         ptr, size,
-                         direction == KVM_EXIT_IO_OUT);
+        if (direction == KVM_EXIT_IO_OUT) {
+            if (!ioport_dispatch_write(port, size_memop(size),
+                                       ldn_he_p(ptr, size), attrs)) {
+                address_space_write(&address_space_io, port, attrs,
+                                    ptr, size);
+            }
+        } else {
+            uint64_t val;
+
+            if (ioport_dispatch_read(port, size_memop(size), &val, attrs)) {
+                stn_he_p(ptr, size, val);
+            } else {
+                address_space_read(&address_space_io, port, attrs,
+                                   ptr, size);
+            }
+        }
         ptr += size;
     }
 }
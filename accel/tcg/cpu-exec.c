@@ -452,6 +452,10 @@ cpu_tb_exec(CPUState *cpu, TranslationBlock *itb, int *tb_exit)
 
     trace_exec_tb_exit(last_tb, *tb_exit);
 
+    if (unlikely(last_tb && last_tb->profile)) {
+        qatomic_inc(&last_tb->profile->exits[*tb_exit]);
+    }
+
     if (*tb_exit > TB_EXIT_IDX1) {
         /* We didn't start executing this TB (eg because the instruction
          * counter hit zero); we must restore the guest PC to the address
@@ -797,6 +801,10 @@ static inline bool cpu_handle_interrupt(CPUState *cpu,
 #ifdef CONFIG_USER_ONLY
     assert(!cpu_test_interrupt(cpu, ~0));
 #else
+    if (unlikely(qatomic_read(&cpu->profile_sample))) {
+        tcg_profile_sample(cpu);
+    }
+
     if (unlikely(cpu_test_interrupt(cpu, ~0))) {
         bql_lock();
         if (cpu_test_interrupt(cpu, CPU_INTERRUPT_DEBUG)) {
@@ -916,13 +924,21 @@ static inline void cpu_loop_exec_tb(CPUState *cpu, TranslationBlock *tb,
 
     /*
      * If the next tb has more instructions than we have left to
-     * execute we need to ensure we find/generate a TB with exactly
-     * insns_left instructions in it.
+     * execute, only replay needs to stop at exactly the end of the
+     * budget, and so to find/generate a TB with exactly insns_left
+     * instructions in it.  Otherwise the budget only approximates the
+     * next timer deadline: stretch it to cover the whole TB, rather
+     * than translating a truncated copy of it for every time slice.
      */
     if (insns_left > 0 && insns_left < tb->icount)  {
         assert(insns_left <= CF_COUNT_MASK);
         assert(cpu->icount_extra == 0);
-        cpu->cflags_next_tb = (tb->cflags & ~CF_COUNT_MASK) | insns_left;
+        if (replay_mode == REPLAY_MODE_PLAY) {
+            cpu->cflags_next_tb = (tb->cflags & ~CF_COUNT_MASK) | insns_left;
+        } else {
+            cpu->icount_budget += tb->icount - insns_left;
+            cpu->neg.icount_decr.u16.low = tb->icount;
+        }
     }
 #endif
 }
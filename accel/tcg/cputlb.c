@@ -144,6 +144,7 @@ static void tlb_window_reset(CPUTLBDesc *desc, int64_t ns,
 {
     desc->window_begin_ns = ns;
     desc->window_max_entries = max_entries;
+    desc->window_evictions = 0;
 }
 
 static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
@@ -200,6 +201,12 @@ static void tb_jmp_cache_clear_page(CPUState *cpu, vaddr page_addr)
  * is direct mapped, so we want the use rate to be low (or at least not too
  * high), since otherwise we are likely to have a significant amount of
  * conflict misses.
+ *
+ * 4. Measure those conflict misses directly, by counting the valid entries
+ * that were evicted by a different page during the window. If more entries
+ * were evicted than the TLB holds, the working set is thrashing the direct
+ * mapped table even though its use rate looks moderate, so grow it already
+ * above a 40% use rate, and never shrink it.
  */
 static void tlb_mmu_resize_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast,
                                   int64_t now)
@@ -210,15 +217,16 @@ static void tlb_mmu_resize_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast,
     int64_t window_len_ms = 100;
     int64_t window_len_ns = window_len_ms * 1000 * 1000;
     bool window_expired = now > desc->window_begin_ns + window_len_ns;
+    bool thrashing = desc->window_evictions > old_size;
 
     if (desc->n_used_entries > desc->window_max_entries) {
         desc->window_max_entries = desc->n_used_entries;
     }
     rate = desc->window_max_entries * 100 / old_size;
 
-    if (rate > 70) {
+    if (rate > 70 || (rate > 40 && thrashing)) {
         new_size = MIN(old_size << 1, 1 << CPU_TLB_DYN_MAX_BITS);
-    } else if (rate < 30 && window_expired) {
+    } else if (rate < 30 && window_expired && !thrashing) {
         size_t ceil = pow2ceil(desc->window_max_entries);
         size_t expected_rate = desc->window_max_entries * 100 / ceil;
 
@@ -282,8 +290,18 @@ static void tlb_mmu_flush_locked(CPUTLBDesc *desc, CPUTLBDescFast *fast)
     desc->large_page_addr = -1;
     desc->large_page_mask = -1;
     desc->vindex = 0;
+    desc->lindex = 0;
     memset(fast->table, -1, sizeof_tlb(fast));
     memset(desc->vtable, -1, sizeof(desc->vtable));
+    memset(desc->ltable, -1, sizeof(desc->ltable));
+}
+
+/* Empty the direct window if @addr lies below its limit. */
+static inline void tlb_flush_direct_locked(CPUState *cpu, vaddr addr)
+{
+    if (addr < cpu->neg.tlb.direct.limit) {
+        cpu->neg.tlb.direct.limit = 0;
+    }
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
@@ -292,6 +310,7 @@ static void tlb_flush_one_mmuidx_locked(CPUState *cpu, int mmu_idx,
     CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
     CPUTLBDescFast *fast = cpu_tlb_fast(cpu, mmu_idx);
 
+    tlb_flush_direct_locked(cpu, 0);
     tlb_mmu_resize_locked(desc, fast, now);
     tlb_mmu_flush_locked(desc, fast);
 }
@@ -327,6 +346,7 @@ void tlb_init(CPUState *cpu)
 
     /* All tlbs are initialized flushed. */
     cpu->neg.tlb.c.dirty = 0;
+    cpu->neg.tlb.direct.limit = 0;
 
     for (i = 0; i < NB_MMU_MODES; i++) {
         tlb_mmu_init(&cpu->neg.tlb.d[i], cpu_tlb_fast(cpu, i), now);
@@ -499,23 +519,74 @@ static inline void tlb_flush_vtlb_page_locked(CPUState *cpu, int mmu_idx,
     tlb_flush_vtlb_page_mask_locked(cpu, mmu_idx, page, -1);
 }
 
+/*
+ * Flush all of the TARGET_PAGE_SIZE pieces of the large page @lp
+ * from the tlb and the victim tlb, and drop @lp itself.
+ * Called with tlb_c.lock held.
+ */
+static void tlb_flush_large_page_locked(CPUState *cpu, int midx,
+                                        CPUTLBLargeEntry *lp)
+{
+    CPUTLBDescFast *f = cpu_tlb_fast(cpu, midx);
+    size_t n_entries = tlb_n_entries(f);
+    vaddr size = -lp->mask;
+
+    tlb_debug("flush large page midx %d (%016" VADDR_PRIx "/%016"
+              VADDR_PRIx ")\n", midx, lp->addr, lp->mask);
+
+    /*
+     * Test each page of the large page if there are fewer of those
+     * than there are entries in the tlb; otherwise test each entry.
+     */
+    if ((size >> TARGET_PAGE_BITS) <= n_entries) {
+        for (vaddr i = 0; i < size; i += TARGET_PAGE_SIZE) {
+            vaddr page = lp->addr + i;
+
+            if (tlb_flush_entry_locked(tlb_entry(cpu, midx, page), page)) {
+                tlb_n_used_entries_dec(cpu, midx);
+            }
+        }
+    } else {
+        for (size_t i = 0; i < n_entries; i++) {
+            if (tlb_flush_entry_mask_locked(&f->table[i],
+                                            lp->addr, lp->mask)) {
+                tlb_n_used_entries_dec(cpu, midx);
+            }
+        }
+    }
+    tlb_flush_vtlb_page_mask_locked(cpu, midx, lp->addr, lp->mask);
+    memset(lp, -1, sizeof(*lp));
+}
+
 static void tlb_flush_page_locked(CPUState *cpu, int midx, vaddr page)
 {
-    vaddr lp_addr = cpu->neg.tlb.d[midx].large_page_addr;
-    vaddr lp_mask = cpu->neg.tlb.d[midx].large_page_mask;
+    CPUTLBDesc *d = &cpu->neg.tlb.d[midx];
+    vaddr lp_addr = d->large_page_addr;
+    vaddr lp_mask = d->large_page_mask;
 
-    /* Check if we need to flush due to large pages.  */
+    tlb_flush_direct_locked(cpu, page);
+
+    /* Check if we need to flush due to evicted large pages.  */
     if ((page & lp_mask) == lp_addr) {
         tlb_debug("forcing full flush midx %d (%016"
                   VADDR_PRIx "/%016" VADDR_PRIx ")\n",
                   midx, lp_addr, lp_mask);
         tlb_flush_one_mmuidx_locked(cpu, midx, get_clock_realtime());
-    } else {
-        if (tlb_flush_entry_locked(tlb_entry(cpu, midx, page), page)) {
-            tlb_n_used_entries_dec(cpu, midx);
+        return;
+    }
+
+    for (int i = 0; i < CPU_LTLB_SIZE; i++) {
+        CPUTLBLargeEntry *lp = &d->ltable[i];
+
+        if ((page & lp->mask) == lp->addr) {
+            tlb_flush_large_page_locked(cpu, midx, lp);
         }
-        tlb_flush_vtlb_page_locked(cpu, midx, page);
     }
+
+    if (tlb_flush_entry_locked(tlb_entry(cpu, midx, page), page)) {
+        tlb_n_used_entries_dec(cpu, midx);
+    }
+    tlb_flush_vtlb_page_locked(cpu, midx, page);
 }
 
 /**
@@ -668,6 +739,9 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
     CPUTLBDescFast *f = cpu_tlb_fast(cpu, midx);
     vaddr mask = MAKE_64BIT_MASK(0, bits);
 
+    /* The range may wrap under @mask; don't bother being precise. */
+    tlb_flush_direct_locked(cpu, 0);
+
     /*
      * If @bits is smaller than the tlb size, there may be multiple entries
      * within the TLB; otherwise all addresses that match under @mask hit
@@ -687,7 +761,7 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
     }
 
     /*
-     * Check if we need to flush due to large pages.
+     * Check if we need to flush due to evicted large pages.
      * Because large_page_mask contains all 1's from the msb,
      * we only need to test the end of the range.
      */
@@ -699,6 +773,23 @@ static void tlb_flush_range_locked(CPUState *cpu, int midx,
         return;
     }
 
+    /*
+     * Flush any large page that overlaps the range.  If not all of the
+     * address bits are significant, we cannot easily tell which large
+     * pages the range aliases, so flush all of them.
+     */
+    for (int i = 0; i < CPU_LTLB_SIZE; i++) {
+        CPUTLBLargeEntry *lp = &d->ltable[i];
+
+        if (lp->addr == (vaddr)-1) {
+            continue;
+        }
+        if (bits < target_long_bits() ||
+            (lp->addr <= addr + len - 1 && addr <= (lp->addr | ~lp->mask))) {
+            tlb_flush_large_page_locked(cpu, midx, lp);
+        }
+    }
+
     for (vaddr i = 0; i < len; i += TARGET_PAGE_SIZE) {
         vaddr page = addr + i;
         CPUTLBEntry *entry = tlb_entry(cpu, midx, page);
@@ -995,6 +1086,56 @@ static void tlb_add_large_page(CPUState *cpu, int mmu_idx,
     cpu->neg.tlb.d[mmu_idx].large_page_mask = lp_mask;
 }
 
+/*
+ * Record the large page translation @full for @addr in the large page
+ * tlb, so that further misses within the page may be refilled without
+ * calling tlb_fill, and so that flushing a page within it need only
+ * flush the pieces of this one large page.  If an entry must be evicted
+ * to make room, its pieces may still be present in the tlb, so fall
+ * back to tracking it with tlb_add_large_page.
+ */
+static void tlb_add_large_tlb(CPUState *cpu, int mmu_idx, vaddr addr,
+                              uint64_t size, const CPUTLBEntryFull *full)
+{
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+    vaddr mask = ~(vaddr)(size - 1);
+    CPUTLBLargeEntry *lp = NULL;
+
+    for (int i = 0; i < CPU_LTLB_SIZE; i++) {
+        if (desc->ltable[i].addr == (addr & mask) &&
+            desc->ltable[i].mask == mask) {
+            lp = &desc->ltable[i];
+            break;
+        }
+    }
+    if (lp == NULL) {
+        lp = &desc->ltable[desc->lindex++ % CPU_LTLB_SIZE];
+        if (lp->addr != (vaddr)-1) {
+            tlb_add_large_page(cpu, mmu_idx, lp->addr, -lp->mask);
+        }
+    }
+
+    lp->addr = addr & mask;
+    lp->mask = mask;
+    lp->full = *full;
+    lp->full.phys_addr -= addr & ~mask;
+}
+
+/*
+ * Choose the victim tlb slot for an entry evicted from the main tlb.
+ * Entries flushed by page leave holes in the victim tlb; fill those
+ * before replacing live entries in round-robin order.
+ */
+static unsigned victim_tlb_slot(CPUTLBDesc *desc)
+{
+    for (unsigned i = 0; i < CPU_VTLB_SIZE; i++) {
+        if (tlb_entry_is_empty(&desc->vtable[i])) {
+            return i;
+        }
+    }
+    return desc->vindex++ % CPU_VTLB_SIZE;
+}
+
 static inline void tlb_set_compare(CPUTLBEntryFull *full, CPUTLBEntry *ent,
                                    vaddr address, int flags,
                                    MMUAccessType access_type, bool enable)
@@ -1015,8 +1156,9 @@ static inline void tlb_set_compare(CPUTLBEntryFull *full, CPUTLBEntry *ent,
 
 /*
  * Add a new TLB entry. At most one entry for a given virtual address
- * is permitted. Only a single TARGET_PAGE_SIZE region is mapped, the
- * supplied size is only used by tlb_flush_page.
+ * is permitted. Only a single TARGET_PAGE_SIZE region is mapped; a
+ * larger supplied size is recorded in the large page tlb, from which
+ * the rest of the page is refilled, and used by tlb_flush_page.
  *
  * Called from TCG-generated code, which is under an RCU read-side
  * critical section.
@@ -1041,7 +1183,7 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
         sz = TARGET_PAGE_SIZE;
     } else {
         sz = (hwaddr)1 << full->lg_page_size;
-        tlb_add_large_page(cpu, mmu_idx, addr, sz);
+        tlb_add_large_tlb(cpu, mmu_idx, addr, sz, full);
     }
     addr_page = addr & TARGET_PAGE_MASK;
     paddr_page = full->phys_addr & TARGET_PAGE_MASK;
@@ -1128,13 +1270,15 @@ void tlb_set_page_full(CPUState *cpu, int mmu_idx,
      * different page; otherwise just overwrite the stale data.
      */
     if (!tlb_hit_page_anyprot(te, addr_page) && !tlb_entry_is_empty(te)) {
-        unsigned vidx = desc->vindex++ % CPU_VTLB_SIZE;
+        unsigned vidx = victim_tlb_slot(desc);
         CPUTLBEntry *tv = &desc->vtable[vidx];
 
         /* Evict the old entry into the victim tlb.  */
         copy_tlb_helper_locked(tv, te);
         desc->vfulltlb[vidx] = desc->fulltlb[index];
         tlb_n_used_entries_dec(cpu, mmu_idx);
+        desc->window_evictions++;
+        qatomic_set(&tlb->c.evict_count, tlb->c.evict_count + 1);
     }
 
     /* refill the tlb */
@@ -1198,6 +1342,27 @@ void tlb_set_page_with_attrs(CPUState *cpu, vaddr addr,
     tlb_set_page_full(cpu, mmu_idx, addr, &full);
 }
 
+void tlb_set_direct_window(CPUState *cpu, void *host, vaddr len)
+{
+    CPUTLBDirect *direct = &cpu->neg.tlb.direct;
+
+    assert_cpu_is_self(cpu);
+
+    /* Watchpoints are only checked by the TLB; keep every load there. */
+    if (!QTAILQ_EMPTY(&cpu->watchpoints)) {
+        return;
+    }
+
+    qemu_spin_lock(&cpu->neg.tlb.c.lock);
+    direct->host = (uintptr_t)host;
+    direct->limit = len & TARGET_PAGE_MASK;
+    /* The window covers every mmu_idx; don't let a full flush be elided. */
+    cpu->neg.tlb.c.dirty = ALL_MMUIDX_BITS;
+    qemu_spin_unlock(&cpu->neg.tlb.c.lock);
+
+    tlb_debug("direct window %016" VADDR_PRIx " at %p\n", direct->limit, host);
+}
+
 void tlb_set_page(CPUState *cpu, vaddr addr,
                   hwaddr paddr, int prot,
                   int mmu_idx, vaddr size)
@@ -1242,6 +1407,8 @@ static bool tlb_fill_align(CPUState *cpu, vaddr addr, MMUAccessType type,
     const TCGCPUOps *ops = cpu->cc->tcg_ops;
     CPUTLBEntryFull full;
 
+    qatomic_set(&cpu->neg.tlb.c.fill_count, cpu->neg.tlb.c.fill_count + 1);
+
     if (ops->tlb_fill_align) {
         if (ops->tlb_fill_align(cpu, &full, addr, type, mmu_idx,
                                 memop, size, probe, ra)) {
@@ -1301,8 +1468,42 @@ static void io_failed(CPUState *cpu, CPUTLBEntryFull *full, vaddr addr,
     }
 }
 
-/* Return true if ADDR is present in the victim tlb, and has been copied
-   back to the main tlb.  */
+/*
+ * Return true if PAGE is within a page of the large page tlb, and the
+ * main tlb has been refilled from it with a translation valid for
+ * ACCESS_TYPE.
+ */
+static bool large_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
+                          MMUAccessType access_type, vaddr page)
+{
+    CPUTLBDesc *desc = &cpu->neg.tlb.d[mmu_idx];
+
+    for (int i = 0; i < CPU_LTLB_SIZE; i++) {
+        CPUTLBLargeEntry *lp = &desc->ltable[i];
+
+        if ((page & lp->mask) == lp->addr) {
+            CPUTLBEntryFull full = lp->full;
+            CPUTLBEntry *te;
+
+            full.phys_addr += page - lp->addr;
+            tlb_set_page_full(cpu, mmu_idx, page, &full);
+
+            te = &cpu_tlb_fast(cpu, mmu_idx)->table[index];
+            if (!tlb_hit_page(tlb_read_idx(te, access_type), page)) {
+                return false;
+            }
+            qatomic_set(&cpu->neg.tlb.c.large_hit_count,
+                        cpu->neg.tlb.c.large_hit_count + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ * Return true if ADDR is present in the victim tlb or the large page tlb,
+ * and has been copied back to the main tlb.
+ */
 static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
                            MMUAccessType access_type, vaddr page)
 {
@@ -1327,10 +1528,13 @@ static bool victim_tlb_hit(CPUState *cpu, size_t mmu_idx, size_t index,
             CPUTLBEntryFull *f2 = &cpu->neg.tlb.d[mmu_idx].vfulltlb[vidx];
             CPUTLBEntryFull tmpf;
             tmpf = *f1; *f1 = *f2; *f2 = tmpf;
+
+            qatomic_set(&cpu->neg.tlb.c.victim_hit_count,
+                        cpu->neg.tlb.c.victim_hit_count + 1);
             return true;
         }
     }
-    return false;
+    return large_tlb_hit(cpu, mmu_idx, index, access_type, page);
 }
 
 static void notdirty_write(CPUState *cpu, vaddr mem_vaddr, unsigned size,
@@ -18,6 +18,40 @@ extern int64_t max_delay;
 extern int64_t max_advance;
 
 extern bool one_insn_per_tb;
+extern bool tb_profile_enabled;
+
+/*
+ * Statistics kept with -accel tcg,tb-profile=on.  They are shared by
+ * all translations of the guest block at the same pc, cs_base and
+ * flags, and so survive TB invalidation and flushes.  The execution
+ * count is updated by generated code without atomics and is only
+ * approximate when vCPUs run in parallel; exits are counted exactly.
+ */
+typedef struct TBProfile {
+    vaddr pc;
+    uint64_t cs_base;
+    uint32_t flags;
+
+    /* Describe the latest translation */
+    uint32_t icount;
+    uint32_t host_size;
+    uint32_t ops_before_opt;
+    uint32_t ops_after_opt;
+    uint32_t helper_calls;
+
+    uint64_t translations;
+    uint64_t translate_ns;
+
+    /* Incremented by the generated code on entry, non-atomically */
+    size_t exec_count;
+    /* Returns to the execution loop, indexed by TB_EXIT_*, atomic */
+    size_t exits[4];
+} TBProfile;
+
+TBProfile *tb_profile_get(vaddr pc, uint64_t cs_base, uint32_t flags);
+void tb_profile_translated(TBProfile *p, const TranslationBlock *tb,
+                           int64_t ns, int ops_before_opt, int ops_after_opt,
+                           int helper_calls);
 
 extern bool icount_align_option;
 
@@ -135,11 +169,15 @@ void page_table_config_init(void);
 
 #ifndef CONFIG_USER_ONLY
 G_NORETURN void cpu_io_recompile(CPUState *cpu, uintptr_t retaddr);
+
+/* Record the current guest PC of @cpu for the sampling profiler. */
+void tcg_profile_sample(CPUState *cpu);
 #endif /* CONFIG_USER_ONLY */
 
 void tb_phys_invalidate(TranslationBlock *tb, tb_page_addr_t page_addr);
 void tb_set_jmp_target(TranslationBlock *tb, int n, uintptr_t addr);
 
 void tcg_get_stats(AccelState *accel, GString *buf);
+void tcg_dump_tb_profile(GString *buf);
 
 #endif
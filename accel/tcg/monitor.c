@@ -11,6 +11,8 @@
 #include "qapi/type-helpers.h"
 #include "qapi/qapi-commands-machine.h"
 #include "monitor/monitor.h"
+#include "hw/core/cpu.h"
+#include "system/stats.h"
 #include "system/tcg.h"
 #include "tcg/tcg.h"
 #include "internal-common.h"
@@ -29,9 +31,108 @@ HumanReadableText *qmp_x_query_jit(Error **errp)
     return human_readable_text_from_str(buf);
 }
 
+HumanReadableText *qmp_x_query_tb_profile(Error **errp)
+{
+    g_autoptr(GString) buf = g_string_new("");
+
+    if (!tcg_enabled()) {
+        error_setg(errp, "JIT information is only available with accel=tcg");
+        return NULL;
+    }
+
+    tcg_dump_tb_profile(buf);
+
+    return human_readable_text_from_str(buf);
+}
+
+typedef struct TCGVCPUStat {
+    const char *name;
+    size_t offset;
+} TCGVCPUStat;
+
+#define TLB_STAT(name, field) { name, offsetof(CPUTLBCommon, field) }
+
+static const TCGVCPUStat tcg_vcpu_stats[] = {
+    TLB_STAT("tlb-fills", fill_count),
+    TLB_STAT("tlb-victim-hits", victim_hit_count),
+    TLB_STAT("tlb-large-hits", large_hit_count),
+    TLB_STAT("tlb-evictions", evict_count),
+    TLB_STAT("tlb-full-flushes", full_flush_count),
+    TLB_STAT("tlb-partial-flushes", part_flush_count),
+    TLB_STAT("tlb-elided-flushes", elide_flush_count),
+};
+
+static void tcg_query_stats_vcpu(StatsResultList **result, CPUState *cpu,
+                                 strList *names)
+{
+    StatsList *stats_list = NULL;
+
+    for (int i = ARRAY_SIZE(tcg_vcpu_stats) - 1; i >= 0; i--) {
+        const TCGVCPUStat *desc = &tcg_vcpu_stats[i];
+        size_t *counter = (void *)&cpu->neg.tlb.c + desc->offset;
+        Stats *stats;
+
+        if (!apply_str_list_filter(desc->name, names)) {
+            continue;
+        }
+        stats = g_new0(Stats, 1);
+        stats->name = g_strdup(desc->name);
+        stats->value = g_new0(StatsValue, 1);
+        stats->value->type = QTYPE_QNUM;
+        stats->value->u.scalar = qatomic_read(counter);
+        QAPI_LIST_PREPEND(stats_list, stats);
+    }
+
+    if (stats_list) {
+        add_stats_entry(result, STATS_PROVIDER_TCG,
+                        cpu->parent_obj.canonical_path, stats_list);
+    }
+}
+
+static void tcg_query_stats_cb(StatsResultList **result, StatsTarget target,
+                               strList *names, strList *targets, Error **errp)
+{
+    CPUState *cpu;
+
+    if (!tcg_enabled() || target != STATS_TARGET_VCPU) {
+        return;
+    }
+
+    CPU_FOREACH(cpu) {
+        if (!apply_str_list_filter(cpu->parent_obj.canonical_path, targets)) {
+            continue;
+        }
+        tcg_query_stats_vcpu(result, cpu, names);
+    }
+}
+
+static void tcg_query_stats_schemas_cb(StatsSchemaList **result, Error **errp)
+{
+    StatsSchemaValueList *stats_list = NULL;
+
+    if (!tcg_enabled()) {
+        return;
+    }
+
+    for (int i = ARRAY_SIZE(tcg_vcpu_stats) - 1; i >= 0; i--) {
+        StatsSchemaValue *value = g_new0(StatsSchemaValue, 1);
+
+        value->name = g_strdup(tcg_vcpu_stats[i].name);
+        value->type = STATS_TYPE_CUMULATIVE;
+        QAPI_LIST_PREPEND(stats_list, value);
+    }
+
+    add_stats_schema(result, STATS_PROVIDER_TCG, STATS_TARGET_VCPU,
+                     stats_list);
+}
+
 static void hmp_tcg_register(void)
 {
     monitor_register_hmp_info_hrt("jit", qmp_x_query_jit);
+    monitor_register_hmp_info_hrt("tcg-profile", qmp_x_query_tcg_profile);
+    monitor_register_hmp_info_hrt("tb-profile", qmp_x_query_tb_profile);
+    add_stats_callbacks(STATS_PROVIDER_TCG, tcg_query_stats_cb,
+                        tcg_query_stats_schemas_cb);
 }
 
 type_init(hmp_tcg_register);
@@ -186,10 +186,23 @@ static int v_l2_levels;
 
 static void *l1_map[V_L1_MAX_SIZE];
 
+/*
+ * Each PageDesc keeps a coarse map of the bytes covered by its TBs, with
+ * one bit per 1/32nd of the page.  The map is updated with the page lock
+ * held, but is read without it: a write that does not intersect any set
+ * bit cannot invalidate a TB on the page, so the page locks (and the
+ * page_collection that would lock every intersecting TB's pages) can be
+ * skipped entirely.  This keeps vCPUs that write data next to code, or
+ * DMA that touches a code page, from serializing on the page locks.
+ */
+#define PAGE_CODE_MAP_BITS  5
+
 struct PageDesc {
     QemuSpin lock;
     /* list of TBs intersecting this ram page */
     uintptr_t first_tb;
+    /* chunks of the page covered by first_tb; see PAGE_CODE_MAP_BITS */
+    uint32_t code_map;
 };
 
 void page_table_config_init(void)
@@ -272,6 +285,31 @@ static inline PageDesc *page_find(tb_page_addr_t index)
     return page_find_alloc(index, false);
 }
 
+/* Return the code_map bits for [@start, @last], which may not cross a page. */
+static uint32_t page_code_mask(tb_page_addr_t start, tb_page_addr_t last)
+{
+    int shift = TARGET_PAGE_BITS - PAGE_CODE_MAP_BITS;
+    unsigned first = (start & ~TARGET_PAGE_MASK) >> shift;
+    unsigned end = (last & ~TARGET_PAGE_MASK) >> shift;
+
+    return MAKE_64BIT_MASK(first, end - first + 1);
+}
+
+/*
+ * Return true if a write to [@start, @last] within the page described
+ * by @pd must take the page locks.  May be called without any lock held.
+ *
+ * A page without TBs has an empty code_map; it still takes the slow
+ * path so that tb_invalidate_phys_page_range__locked() can unprotect it.
+ */
+static bool page_code_intersects(PageDesc *pd, tb_page_addr_t start,
+                                 tb_page_addr_t last)
+{
+    uint32_t map = qatomic_read(&pd->code_map);
+
+    return !map || (map & page_code_mask(start, last));
+}
+
 /**
  * struct page_entry - page descriptor entry
  * @pd:     pointer to the &struct PageDesc of the page this entry represents
@@ -671,6 +709,7 @@ static void tb_remove_all_1(int level, void **lp)
         for (i = 0; i < V_L2_SIZE; ++i) {
             page_lock(&pd[i]);
             pd[i].first_tb = (uintptr_t)NULL;
+            qatomic_set(&pd[i].code_map, 0);
             page_unlock(&pd[i]);
         }
     } else {
@@ -691,16 +730,46 @@ static void tb_remove_all(void)
     }
 }
 
+/*
+ * Return in [@pstart, @plast] the part of the @n'th page of @tb
+ * that is covered by the TB.
+ */
+static void tb_page_extent(const TranslationBlock *tb, unsigned int n,
+                           tb_page_addr_t *pstart, tb_page_addr_t *plast)
+{
+    tb_page_addr_t tb_start, tb_last;
+
+    /* NOTE: this is subtle as a TB may span two physical pages */
+    tb_start = tb_page_addr0(tb);
+    tb_last = tb_start + tb->size - 1;
+    if (n == 0) {
+        tb_last = MIN(tb_last, tb_start | ~TARGET_PAGE_MASK);
+    } else {
+        tb_start = tb_page_addr1(tb);
+        tb_last = tb_start + (tb_last & ~TARGET_PAGE_MASK);
+    }
+    *pstart = tb_start;
+    *plast = tb_last;
+}
+
 /*
  * Add the tb in the target page and protect it if necessary.
  * Called with @p->lock held.
  */
 static void tb_page_add(PageDesc *p, TranslationBlock *tb, unsigned int n)
 {
+    tb_page_addr_t tb_start, tb_last;
     bool page_already_protected;
 
     assert_page_locked(p);
 
+    /*
+     * Publish the code_map bits before the TB can be found via the
+     * hash table; qht_insert() orders this store for lockless readers.
+     */
+    tb_page_extent(tb, n, &tb_start, &tb_last);
+    qatomic_set(&p->code_map, p->code_map | page_code_mask(tb_start, tb_last));
+
     tb->page_next[n] = p->first_tb;
     page_already_protected = p->first_tb != 0;
     p->first_tb = (uintptr_t)tb | n;
@@ -729,6 +798,26 @@ static void tb_record(TranslationBlock *tb)
     tb_page_add(page_find_alloc(pindex0, false), tb, 0);
 }
 
+/*
+ * Recompute the code_map of @pd from its remaining TBs.
+ * Called with @pd->lock held.
+ */
+static void page_code_map_rebuild(PageDesc *pd)
+{
+    TranslationBlock *tb;
+    PageForEachNext n;
+    uint32_t map = 0;
+
+    assert_page_locked(pd);
+    PAGE_FOR_EACH_TB(unused, unused, pd, tb, n) {
+        tb_page_addr_t tb_start, tb_last;
+
+        tb_page_extent(tb, n, &tb_start, &tb_last);
+        map |= page_code_mask(tb_start, tb_last);
+    }
+    qatomic_set(&pd->code_map, map);
+}
+
 static void tb_page_remove(PageDesc *pd, TranslationBlock *tb)
 {
     TranslationBlock *tb1;
@@ -740,6 +829,7 @@ static void tb_page_remove(PageDesc *pd, TranslationBlock *tb)
     PAGE_FOR_EACH_TB(unused, unused, pd, tb1, n1) {
         if (tb1 == tb) {
             *pprev = tb1->page_next[n1];
+            page_code_map_rebuild(pd);
             return;
         }
         pprev = &tb1->page_next[n1];
@@ -1134,15 +1224,7 @@ tb_invalidate_phys_page_range__locked(CPUState *cpu,
     PAGE_FOR_EACH_TB(start, last, p, tb, n) {
         tb_page_addr_t tb_start, tb_last;
 
-        /* NOTE: this is subtle as a TB may span two physical pages */
-        tb_start = tb_page_addr0(tb);
-        tb_last = tb_start + tb->size - 1;
-        if (n == 0) {
-            tb_last = MIN(tb_last, tb_start | ~TARGET_PAGE_MASK);
-        } else {
-            tb_start = tb_page_addr1(tb);
-            tb_last = tb_start + (tb_last & ~TARGET_PAGE_MASK);
-        }
+        tb_page_extent(tb, n, &tb_start, &tb_last);
         if (!(tb_last < start || tb_start > last)) {
             if (unlikely(current_tb == tb) &&
                 (tb_cflags(current_tb) & CF_COUNT_MASK) != 1) {
@@ -1186,9 +1268,31 @@ void tb_invalidate_phys_range(CPUState *cpu, tb_page_addr_t start,
     struct page_collection *pages;
     tb_page_addr_t index, index_last;
 
+    index_last = last >> TARGET_PAGE_BITS;
+
+    /*
+     * Check the code maps without locking first: most DMA into a code
+     * page hits data next to the code rather than the code itself.
+     */
+    for (index = start >> TARGET_PAGE_BITS; index <= index_last; index++) {
+        PageDesc *pd = page_find(index);
+        tb_page_addr_t page_start, page_last;
+
+        if (pd == NULL) {
+            continue;
+        }
+        page_start = MAX(index << TARGET_PAGE_BITS, start);
+        page_last = MIN((index << TARGET_PAGE_BITS) | ~TARGET_PAGE_MASK, last);
+        if (page_code_intersects(pd, page_start, page_last)) {
+            break;
+        }
+    }
+    if (index > index_last) {
+        return;
+    }
+
     pages = page_collection_lock(start, last);
 
-    index_last = last >> TARGET_PAGE_BITS;
     for (index = start >> TARGET_PAGE_BITS; index <= index_last; index++) {
         PageDesc *pd = page_find(index);
         tb_page_addr_t page_start, page_last;
@@ -1215,9 +1319,9 @@ void tb_invalidate_phys_range_fast(CPUState *cpu, ram_addr_t start,
                                    unsigned len, uintptr_t ra)
 {
     PageDesc *p = page_find(start >> TARGET_PAGE_BITS);
+    ram_addr_t last = start + len - 1;
 
-    if (p) {
-        ram_addr_t last = start + len - 1;
+    if (p && page_code_intersects(p, start, last)) {
         struct page_collection *pages = page_collection_lock(start, last);
 
         tb_invalidate_phys_page_range__locked(cpu, pages, p,
@@ -27,6 +27,7 @@
 #include "exec/cpu-common.h"
 #include "system/tcg.h"
 #include "system/replay.h"
+#include "system/memory.h"
 #include "exec/icount.h"
 #include "qemu/main-loop.h"
 #include "qemu/notify.h"
@@ -93,6 +94,7 @@ static void *mttcg_cpu_thread_fn(void *arg)
             bql_unlock();
             r = tcg_cpu_exec(cpu);
             bql_lock();
+            qemu_flush_coalesced_mmio_buffer();
             switch (r) {
             case EXCP_DEBUG:
                 cpu_handle_guest_debug(cpu);
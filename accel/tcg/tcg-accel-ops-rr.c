@@ -27,6 +27,7 @@
 #include "qemu/lockable.h"
 #include "system/tcg.h"
 #include "system/replay.h"
+#include "system/memory.h"
 #include "exec/icount.h"
 #include "qemu/main-loop.h"
 #include "qemu/notify.h"
@@ -287,6 +288,7 @@ static void *rr_cpu_thread_fn(void *arg)
                     icount_process_data(cpu);
                 }
                 bql_lock();
+                qemu_flush_coalesced_mmio_buffer();
 
                 if (r == EXCP_DEBUG) {
                     cpu_handle_guest_debug(cpu);
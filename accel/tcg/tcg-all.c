@@ -52,6 +52,7 @@ struct TCGState {
 
     OnOffAuto mttcg_enabled;
     bool one_insn_per_tb;
+    bool tb_profile;
     int splitwx_enabled;
     unsigned long tb_size;
 };
@@ -83,6 +84,7 @@ static void tcg_accel_instance_init(Object *obj)
 }
 
 bool one_insn_per_tb;
+bool tb_profile_enabled;
 
 #ifndef CONFIG_USER_ONLY
 static void tcg_vm_change_state(void *opaque, bool running, RunState state)
@@ -242,6 +244,20 @@ static void tcg_set_one_insn_per_tb(Object *obj, bool value, Error **errp)
     qatomic_set(&one_insn_per_tb, value);
 }
 
+static bool tcg_get_tb_profile(Object *obj, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    return s->tb_profile;
+}
+
+static void tcg_set_tb_profile(Object *obj, bool value, Error **errp)
+{
+    TCGState *s = TCG_STATE(obj);
+    s->tb_profile = value;
+    /* Only affects blocks translated from now on */
+    qatomic_set(&tb_profile_enabled, value);
+}
+
 static int tcg_gdbstub_supported_sstep_flags(AccelState *as)
 {
     /*
@@ -288,6 +304,12 @@ static void tcg_accel_class_init(ObjectClass *oc, const void *data)
                                    tcg_set_one_insn_per_tb);
     object_class_property_set_description(oc, "one-insn-per-tb",
         "Only put one guest insn in each translation block");
+
+    object_class_property_add_bool(oc, "tb-profile",
+                                   tcg_get_tb_profile,
+                                   tcg_set_tb_profile);
+    object_class_property_set_description(oc, "tb-profile",
+        "Keep per translation block statistics for x-query-tb-profile");
 }
 
 static const TypeInfo tcg_accel_type = {
@@ -0,0 +1,201 @@
+/*
+ * Sampling profiler for guest code
+ *
+ * A realtime timer periodically asks every vCPU for a sample.  The
+ * request is delivered like cpu_exit(), through icount_decr, so each
+ * vCPU records the guest PC of the translation block it is about to
+ * execute the next time it leaves generated code.  Samples are kept
+ * per vCPU and TB, and are reported in the "folded" format consumed
+ * by flamegraph tools, with guest symbol names where they are known.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qapi/error.h"
+#include "qapi/type-helpers.h"
+#include "qapi/qapi-commands-machine.h"
+#include "qemu/atomic.h"
+#include "qemu/rcu.h"
+#include "qemu/thread.h"
+#include "qemu/timer.h"
+#include "hw/core/cpu.h"
+#include "accel/tcg/cpu-ops.h"
+#include "system/tcg.h"
+#include "tcg/guest-symbols.h"
+#include "internal-common.h"
+
+#define TCG_PROFILE_DEFAULT_PERIOD_US  1000
+
+typedef struct TCGProfileKey {
+    vaddr pc;
+    uint32_t flags;
+    int cpu_index;
+} TCGProfileKey;
+
+typedef struct TCGProfileEntry {
+    TCGProfileKey key;
+    uint64_t count;
+} TCGProfileEntry;
+
+static struct {
+    /* Protects samples and running. */
+    QemuMutex lock;
+    GHashTable *samples;
+    bool running;
+    /* Only accessed with the BQL held. */
+    QEMUTimer *timer;
+    uint32_t period;
+} profile;
+
+static guint tcg_profile_key_hash(gconstpointer p)
+{
+    const TCGProfileKey *k = p;
+
+    return g_int64_hash(&k->pc) ^ k->flags ^ (k->cpu_index << 24);
+}
+
+static gboolean tcg_profile_key_equal(gconstpointer a, gconstpointer b)
+{
+    const TCGProfileKey *ka = a, *kb = b;
+
+    return ka->pc == kb->pc && ka->flags == kb->flags &&
+           ka->cpu_index == kb->cpu_index;
+}
+
+void tcg_profile_sample(CPUState *cpu)
+{
+    TCGTBCPUState s = cpu->cc->tcg_ops->get_tb_cpu_state(cpu);
+    TCGProfileKey key = {
+        .pc = s.pc,
+        .flags = s.flags,
+        .cpu_index = cpu->cpu_index,
+    };
+    TCGProfileEntry *e;
+
+    qatomic_set(&cpu->profile_sample, false);
+
+    qemu_mutex_lock(&profile.lock);
+    if (profile.running) {
+        e = g_hash_table_lookup(profile.samples, &key);
+        if (!e) {
+            e = g_new0(TCGProfileEntry, 1);
+            e->key = key;
+            g_hash_table_add(profile.samples, e);
+        }
+        e->count++;
+    }
+    qemu_mutex_unlock(&profile.lock);
+}
+
+static void tcg_profile_tick(void *opaque)
+{
+    CPUState *cpu;
+
+    CPU_FOREACH(cpu) {
+        qatomic_set(&cpu->profile_sample, true);
+        /* As cpu_exit(), but without asking to leave cpu_exec(). */
+        smp_wmb();
+        qatomic_set(&cpu->neg.icount_decr.u16.high, -1);
+    }
+
+    timer_mod(profile.timer,
+              qemu_clock_get_us(QEMU_CLOCK_REALTIME) + profile.period);
+}
+
+void qmp_x_tcg_profile_start(bool has_period, uint32_t period,
+                             const char *symbols,
+                             bool has_base, uint64_t base, Error **errp)
+{
+    if (!tcg_enabled()) {
+        error_setg(errp, "Profiling is only available with accel=tcg");
+        return;
+    }
+    if (has_period && !period) {
+        error_setg(errp, "Parameter 'period' must be positive");
+        return;
+    }
+    if (!symbols) {
+        guest_symbols_clear();
+    } else if (!guest_symbols_load(symbols, has_base ? base : 0, errp)) {
+        return;
+    }
+
+    qemu_mutex_lock(&profile.lock);
+    g_hash_table_remove_all(profile.samples);
+    profile.running = true;
+    qemu_mutex_unlock(&profile.lock);
+
+    profile.period = has_period ? period : TCG_PROFILE_DEFAULT_PERIOD_US;
+    if (!profile.timer) {
+        profile.timer = timer_new_us(QEMU_CLOCK_REALTIME,
+                                     tcg_profile_tick, NULL);
+    }
+    timer_mod(profile.timer,
+              qemu_clock_get_us(QEMU_CLOCK_REALTIME) + profile.period);
+}
+
+void qmp_x_tcg_profile_stop(Error **errp)
+{
+    if (profile.timer) {
+        timer_del(profile.timer);
+    }
+
+    qemu_mutex_lock(&profile.lock);
+    profile.running = false;
+    qemu_mutex_unlock(&profile.lock);
+}
+
+static gint tcg_profile_entry_cmp(gconstpointer a, gconstpointer b)
+{
+    const TCGProfileEntry *ea = *(TCGProfileEntry * const *)a;
+    const TCGProfileEntry *eb = *(TCGProfileEntry * const *)b;
+
+    return ea->count > eb->count ? -1 : ea->count < eb->count;
+}
+
+HumanReadableText *qmp_x_query_tcg_profile(Error **errp)
+{
+    g_autoptr(GString) buf = g_string_new("");
+    g_autoptr(GPtrArray) entries = g_ptr_array_new_with_free_func(g_free);
+    GHashTableIter iter;
+    gpointer e;
+
+    if (!tcg_enabled()) {
+        error_setg(errp, "Profiling is only available with accel=tcg");
+        return NULL;
+    }
+
+    /* Take a snapshot, so that symbol lookup runs without the lock. */
+    qemu_mutex_lock(&profile.lock);
+    g_hash_table_iter_init(&iter, profile.samples);
+    while (g_hash_table_iter_next(&iter, &e, NULL)) {
+        g_ptr_array_add(entries, g_memdup2(e, sizeof(TCGProfileEntry)));
+    }
+    qemu_mutex_unlock(&profile.lock);
+
+    g_ptr_array_sort(entries, tcg_profile_entry_cmp);
+
+    WITH_RCU_READ_LOCK_GUARD() {
+        for (guint i = 0; i < entries->len; i++) {
+            const TCGProfileEntry *pe = g_ptr_array_index(entries, i);
+            uint64_t offset;
+            const char *sym = guest_symbols_lookup(pe->key.pc, &offset);
+
+            g_string_append_printf(buf, "cpu%d;%s;0x%" VADDR_PRIx " %" PRIu64
+                                   "\n", pe->key.cpu_index,
+                                   sym ? sym : "[unknown]",
+                                   pe->key.pc, pe->count);
+        }
+    }
+
+    return human_readable_text_from_str(buf);
+}
+
+static void __attribute__((constructor)) tcg_profile_init(void)
+{
+    qemu_mutex_init(&profile.lock);
+    profile.samples = g_hash_table_new_full(tcg_profile_key_hash,
+                                            tcg_profile_key_equal,
+                                            g_free, NULL);
+}
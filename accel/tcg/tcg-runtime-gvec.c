@@ -21,6 +21,7 @@
 #include "qemu/host-utils.h"
 #include "exec/helper-proto-common.h"
 #include "tcg/tcg-gvec-desc.h"
+#include "host/tcg-runtime-gvec.c.inc"
 
 
 static inline void clear_high(void *d, intptr_t oprsz, uint32_t desc)
@@ -40,6 +41,11 @@ void HELPER(gvec_add8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_add8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
         *(uint8_t *)(d + i) = *(uint8_t *)(a + i) + *(uint8_t *)(b + i);
     }
@@ -51,6 +57,11 @@ void HELPER(gvec_add16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_add16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
         *(uint16_t *)(d + i) = *(uint16_t *)(a + i) + *(uint16_t *)(b + i);
     }
@@ -62,6 +73,11 @@ void HELPER(gvec_add32)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_add32, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
         *(uint32_t *)(d + i) = *(uint32_t *)(a + i) + *(uint32_t *)(b + i);
     }
@@ -73,6 +89,11 @@ void HELPER(gvec_add64)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_add64, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) + *(uint64_t *)(b + i);
     }
@@ -128,6 +149,11 @@ void HELPER(gvec_sub8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_sub8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
         *(uint8_t *)(d + i) = *(uint8_t *)(a + i) - *(uint8_t *)(b + i);
     }
@@ -139,6 +165,11 @@ void HELPER(gvec_sub16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_sub16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
         *(uint16_t *)(d + i) = *(uint16_t *)(a + i) - *(uint16_t *)(b + i);
     }
@@ -150,6 +181,11 @@ void HELPER(gvec_sub32)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_sub32, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
         *(uint32_t *)(d + i) = *(uint32_t *)(a + i) - *(uint32_t *)(b + i);
     }
@@ -161,6 +197,11 @@ void HELPER(gvec_sub64)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_sub64, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) - *(uint64_t *)(b + i);
     }
@@ -227,6 +268,11 @@ void HELPER(gvec_mul16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_mul16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
         *(uint16_t *)(d + i) = *(uint16_t *)(a + i) * *(uint16_t *)(b + i);
     }
@@ -238,6 +284,11 @@ void HELPER(gvec_mul32)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_mul32, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
         *(uint32_t *)(d + i) = *(uint32_t *)(a + i) * *(uint32_t *)(b + i);
     }
@@ -249,6 +300,11 @@ void HELPER(gvec_mul64)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_mul64, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) * *(uint64_t *)(b + i);
     }
@@ -455,6 +511,11 @@ void HELPER(gvec_and)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_and, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) & *(uint64_t *)(b + i);
     }
@@ -466,6 +527,11 @@ void HELPER(gvec_or)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_or, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) | *(uint64_t *)(b + i);
     }
@@ -477,6 +543,11 @@ void HELPER(gvec_xor)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_xor, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) ^ *(uint64_t *)(b + i);
     }
@@ -488,6 +559,11 @@ void HELPER(gvec_andc)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_andc, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         *(uint64_t *)(d + i) = *(uint64_t *)(a + i) &~ *(uint64_t *)(b + i);
     }
@@ -1072,6 +1148,11 @@ void HELPER(gvec_ssadd8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_ssadd8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int8_t)) {
         int r = *(int8_t *)(a + i) + *(int8_t *)(b + i);
         if (r > INT8_MAX) {
@@ -1089,6 +1170,11 @@ void HELPER(gvec_ssadd16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_ssadd16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int16_t)) {
         int r = *(int16_t *)(a + i) + *(int16_t *)(b + i);
         if (r > INT16_MAX) {
@@ -1140,6 +1226,11 @@ void HELPER(gvec_sssub8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_sssub8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
         int r = *(int8_t *)(a + i) - *(int8_t *)(b + i);
         if (r > INT8_MAX) {
@@ -1157,6 +1248,11 @@ void HELPER(gvec_sssub16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_sssub16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int16_t)) {
         int r = *(int16_t *)(a + i) - *(int16_t *)(b + i);
         if (r > INT16_MAX) {
@@ -1208,6 +1304,11 @@ void HELPER(gvec_usadd8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_usadd8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
         unsigned r = *(uint8_t *)(a + i) + *(uint8_t *)(b + i);
         if (r > UINT8_MAX) {
@@ -1223,6 +1324,11 @@ void HELPER(gvec_usadd16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_usadd16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
         unsigned r = *(uint16_t *)(a + i) + *(uint16_t *)(b + i);
         if (r > UINT16_MAX) {
@@ -1272,6 +1378,11 @@ void HELPER(gvec_ussub8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_ussub8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
         int r = *(uint8_t *)(a + i) - *(uint8_t *)(b + i);
         if (r < 0) {
@@ -1287,6 +1398,11 @@ void HELPER(gvec_ussub16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_ussub16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
         int r = *(uint16_t *)(a + i) - *(uint16_t *)(b + i);
         if (r < 0) {
@@ -1336,6 +1452,11 @@ void HELPER(gvec_smin8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smin8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int8_t)) {
         int8_t aa = *(int8_t *)(a + i);
         int8_t bb = *(int8_t *)(b + i);
@@ -1350,6 +1471,11 @@ void HELPER(gvec_smin16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smin16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int16_t)) {
         int16_t aa = *(int16_t *)(a + i);
         int16_t bb = *(int16_t *)(b + i);
@@ -1364,6 +1490,11 @@ void HELPER(gvec_smin32)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smin32, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int32_t)) {
         int32_t aa = *(int32_t *)(a + i);
         int32_t bb = *(int32_t *)(b + i);
@@ -1378,6 +1509,11 @@ void HELPER(gvec_smin64)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smin64, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int64_t)) {
         int64_t aa = *(int64_t *)(a + i);
         int64_t bb = *(int64_t *)(b + i);
@@ -1392,6 +1528,11 @@ void HELPER(gvec_smax8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smax8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int8_t)) {
         int8_t aa = *(int8_t *)(a + i);
         int8_t bb = *(int8_t *)(b + i);
@@ -1406,6 +1547,11 @@ void HELPER(gvec_smax16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smax16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int16_t)) {
         int16_t aa = *(int16_t *)(a + i);
         int16_t bb = *(int16_t *)(b + i);
@@ -1420,6 +1566,11 @@ void HELPER(gvec_smax32)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smax32, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int32_t)) {
         int32_t aa = *(int32_t *)(a + i);
         int32_t bb = *(int32_t *)(b + i);
@@ -1434,6 +1585,11 @@ void HELPER(gvec_smax64)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_smax64, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(int64_t)) {
         int64_t aa = *(int64_t *)(a + i);
         int64_t bb = *(int64_t *)(b + i);
@@ -1448,6 +1604,11 @@ void HELPER(gvec_umin8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umin8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
         uint8_t aa = *(uint8_t *)(a + i);
         uint8_t bb = *(uint8_t *)(b + i);
@@ -1462,6 +1623,11 @@ void HELPER(gvec_umin16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umin16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
         uint16_t aa = *(uint16_t *)(a + i);
         uint16_t bb = *(uint16_t *)(b + i);
@@ -1476,6 +1642,11 @@ void HELPER(gvec_umin32)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umin32, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
         uint32_t aa = *(uint32_t *)(a + i);
         uint32_t bb = *(uint32_t *)(b + i);
@@ -1490,6 +1661,11 @@ void HELPER(gvec_umin64)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umin64, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         uint64_t aa = *(uint64_t *)(a + i);
         uint64_t bb = *(uint64_t *)(b + i);
@@ -1504,6 +1680,11 @@ void HELPER(gvec_umax8)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umax8, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint8_t)) {
         uint8_t aa = *(uint8_t *)(a + i);
         uint8_t bb = *(uint8_t *)(b + i);
@@ -1518,6 +1699,11 @@ void HELPER(gvec_umax16)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umax16, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint16_t)) {
         uint16_t aa = *(uint16_t *)(a + i);
         uint16_t bb = *(uint16_t *)(b + i);
@@ -1532,6 +1718,11 @@ void HELPER(gvec_umax32)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umax32, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint32_t)) {
         uint32_t aa = *(uint32_t *)(a + i);
         uint32_t bb = *(uint32_t *)(b + i);
@@ -1546,6 +1737,11 @@ void HELPER(gvec_umax64)(void *d, void *a, void *b, uint32_t desc)
     intptr_t oprsz = simd_oprsz(desc);
     intptr_t i;
 
+    if (gvec_accel3(gvec_umax64, d, a, b, oprsz)) {
+        clear_high(d, oprsz, desc);
+        return;
+    }
+
     for (i = 0; i < oprsz; i += sizeof(uint64_t)) {
         uint64_t aa = *(uint64_t *)(a + i);
         uint64_t bb = *(uint64_t *)(b + i);
@@ -9,6 +9,7 @@
 #include "qemu/osdep.h"
 #include "qemu/accel.h"
 #include "qemu/qht.h"
+#include "qemu/thread.h"
 #include "qapi/error.h"
 #include "system/cpu-timers.h"
 #include "exec/icount.h"
@@ -147,9 +148,25 @@ static void tlb_flush_counts(size_t *pfull, size_t *ppart, size_t *pelide)
     *pelide = elide;
 }
 
+static void tlb_miss_counts(size_t *pvictim, size_t *plarge, size_t *pfill)
+{
+    CPUState *cpu;
+    size_t victim = 0, large = 0, fill = 0;
+
+    CPU_FOREACH(cpu) {
+        victim += qatomic_read(&cpu->neg.tlb.c.victim_hit_count);
+        large += qatomic_read(&cpu->neg.tlb.c.large_hit_count);
+        fill += qatomic_read(&cpu->neg.tlb.c.fill_count);
+    }
+    *pvictim = victim;
+    *plarge = large;
+    *pfill = fill;
+}
+
 static void tcg_dump_flush_info(GString *buf)
 {
     size_t flush_full, flush_part, flush_elide;
+    size_t miss_victim, miss_large, miss_fill;
 
     g_string_append_printf(buf, "TB flush count      %u\n",
                            qatomic_read(&tb_ctx.tb_flush_count));
@@ -160,6 +177,11 @@ static void tcg_dump_flush_info(GString *buf)
     g_string_append_printf(buf, "TLB full flushes    %zu\n", flush_full);
     g_string_append_printf(buf, "TLB partial flushes %zu\n", flush_part);
     g_string_append_printf(buf, "TLB elided flushes  %zu\n", flush_elide);
+
+    tlb_miss_counts(&miss_victim, &miss_large, &miss_fill);
+    g_string_append_printf(buf, "TLB victim hits     %zu\n", miss_victim);
+    g_string_append_printf(buf, "TLB large page hits %zu\n", miss_large);
+    g_string_append_printf(buf, "TLB fills           %zu\n", miss_fill);
 }
 
 static void dump_exec_info(GString *buf)
@@ -217,3 +239,135 @@ void tcg_dump_stats(GString *buf)
 {
     tcg_get_stats(current_accel(), buf);
 }
+
+#define TB_PROFILE_REPORT_LIMIT 50
+
+static struct {
+    /* Protects table and the translation statistics of its entries. */
+    QemuMutex lock;
+    GHashTable *table;
+} tb_profiles;
+
+static guint tb_profile_hash(gconstpointer v)
+{
+    const TBProfile *p = v;
+
+    return g_int64_hash(&p->pc) ^ g_int64_hash(&p->cs_base) ^ p->flags;
+}
+
+static gboolean tb_profile_equal(gconstpointer a, gconstpointer b)
+{
+    const TBProfile *pa = a, *pb = b;
+
+    return pa->pc == pb->pc && pa->cs_base == pb->cs_base &&
+           pa->flags == pb->flags;
+}
+
+TBProfile *tb_profile_get(vaddr pc, uint64_t cs_base, uint32_t flags)
+{
+    TBProfile key = { .pc = pc, .cs_base = cs_base, .flags = flags };
+    TBProfile *p;
+
+    qemu_mutex_lock(&tb_profiles.lock);
+    p = g_hash_table_lookup(tb_profiles.table, &key);
+    if (!p) {
+        p = g_memdup2(&key, sizeof(key));
+        g_hash_table_add(tb_profiles.table, p);
+    }
+    qemu_mutex_unlock(&tb_profiles.lock);
+
+    return p;
+}
+
+void tb_profile_translated(TBProfile *p, const TranslationBlock *tb,
+                           int64_t ns, int ops_before_opt, int ops_after_opt,
+                           int helper_calls)
+{
+    qemu_mutex_lock(&tb_profiles.lock);
+    p->icount = tb->icount;
+    p->host_size = tb->tc.size;
+    p->ops_before_opt = ops_before_opt;
+    p->ops_after_opt = ops_after_opt;
+    p->helper_calls = helper_calls;
+    p->translations++;
+    p->translate_ns += ns;
+    qemu_mutex_unlock(&tb_profiles.lock);
+}
+
+/* Estimate the time spent in a block by the host code it ran. */
+static uint64_t tb_profile_cost(const TBProfile *p)
+{
+    return (uint64_t)qatomic_read(&p->exec_count) * p->host_size;
+}
+
+static gint tb_profile_cmp(gconstpointer a, gconstpointer b)
+{
+    uint64_t ca = tb_profile_cost(*(TBProfile * const *)a);
+    uint64_t cb = tb_profile_cost(*(TBProfile * const *)b);
+
+    return ca > cb ? -1 : ca < cb;
+}
+
+void tcg_dump_tb_profile(GString *buf)
+{
+    g_autoptr(GPtrArray) profiles = g_ptr_array_new();
+    GHashTableIter iter;
+    gpointer p;
+    uint64_t translate_ns = 0;
+
+    QEMU_BUILD_BUG_ON(ARRAY_SIZE(((TBProfile *)0)->exits) !=
+                      TB_EXIT_MASK + 1);
+
+    qemu_mutex_lock(&tb_profiles.lock);
+
+    g_hash_table_iter_init(&iter, tb_profiles.table);
+    while (g_hash_table_iter_next(&iter, &p, NULL)) {
+        translate_ns += ((TBProfile *)p)->translate_ns;
+        g_ptr_array_add(profiles, p);
+    }
+    g_ptr_array_sort(profiles, tb_profile_cmp);
+
+    if (!qatomic_read(&tb_profile_enabled)) {
+        g_string_append(buf, "TB profiling is off, "
+                        "enable it with -accel tcg,tb-profile=on\n");
+    }
+    g_string_append_printf(buf, "%u blocks profiled, "
+                           "%" PRIu64 " us spent translating them\n\n",
+                           profiles->len, translate_ns / SCALE_US);
+    if (!profiles->len) {
+        goto out;
+    }
+
+    g_string_append_printf(buf, "%-18s %5s %5s %9s %11s %7s %6s %12s "
+                           "%9s %9s %9s\n", "pc", "insns", "xlate",
+                           "xlate-us", "ops/opt", "helpers", "host",
+                           "execs", "exit-0", "exit-1", "exit-req");
+
+    for (guint i = 0; i < MIN(profiles->len, TB_PROFILE_REPORT_LIMIT); i++) {
+        const TBProfile *tp = g_ptr_array_index(profiles, i);
+        g_autofree char *ops = g_strdup_printf("%u/%u", tp->ops_before_opt,
+                                               tp->ops_after_opt);
+
+        g_string_append_printf(buf, "0x%016" VADDR_PRIx " %5u %5" PRIu64
+                               " %9" PRIu64 " %11s %7u %6u %12zu "
+                               "%9zu %9zu %9zu\n",
+                               tp->pc, tp->icount, tp->translations,
+                               tp->translate_ns / SCALE_US, ops,
+                               tp->helper_calls, tp->host_size,
+                               qatomic_read(&tp->exec_count),
+                               qatomic_read(&tp->exits[TB_EXIT_IDX0]),
+                               qatomic_read(&tp->exits[TB_EXIT_IDX1]),
+                               qatomic_read(&tp->exits[TB_EXIT_REQUESTED]));
+    }
+
+ out:
+    qemu_mutex_unlock(&tb_profiles.lock);
+}
+
+static void __attribute__((constructor)) tb_profile_init(void)
+{
+    qemu_mutex_init(&tb_profiles.lock);
+    tb_profiles.table = g_hash_table_new_full(tb_profile_hash,
+                                              tb_profile_equal,
+                                              g_free, NULL);
+}
@@ -27,6 +27,7 @@
 #include "exec/tb-flush.h"
 #include "qemu/cacheinfo.h"
 #include "qemu/target-info.h"
+#include "qemu/timer.h"
 #include "exec/log.h"
 #include "exec/icount.h"
 #include "accel/tcg/cpu-ops.h"
@@ -265,7 +266,7 @@ TranslationBlock *tb_gen_code(CPUState *cpu, TCGTBCPUState s)
     tb_page_addr_t phys_pc, phys_p2;
     tcg_insn_unit *gen_code_buf;
     int gen_code_size, search_size, max_insns;
-    int64_t ti;
+    int64_t ti, profile_start = 0;
     void *host_pc;
 
     assert_memory_lock();
@@ -309,6 +310,11 @@ TranslationBlock *tb_gen_code(CPUState *cpu, TCGTBCPUState s)
     tb->cs_base = s.cs_base;
     tb->flags = s.flags;
     tb->cflags = s.cflags;
+    tb->profile = NULL;
+    if (unlikely(qatomic_read(&tb_profile_enabled))) {
+        tb->profile = tb_profile_get(s.pc, s.cs_base, s.flags);
+        profile_start = get_clock();
+    }
     tb_set_page_addr0(tb, phys_pc);
     tb_set_page_addr1(tb, -1);
     if (phys_pc != -1) {
@@ -396,6 +402,18 @@ TranslationBlock *tb_gen_code(CPUState *cpu, TCGTBCPUState s)
     }
     tb->tc.size = gen_code_size;
 
+    if (tb->profile) {
+        int helper_calls = 0;
+        TCGOp *op;
+
+        QTAILQ_FOREACH(op, &tcg_ctx->ops, link) {
+            helper_calls += op->opc == INDEX_op_call;
+        }
+        tb_profile_translated(tb->profile, tb, get_clock() - profile_start,
+                              tcg_ctx->nb_ops_before_opt, tcg_ctx->nb_ops,
+                              helper_calls);
+    }
+
     /*
      * For CF_PCREL, attribute all executions of the generated code
      * to its first mapping.
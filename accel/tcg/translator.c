@@ -82,6 +82,15 @@ static TCGOp *gen_tb_start(DisasContextBase *db, uint32_t cflags)
                          sizeof(CPUState));
     }
 
+    if (db->tb->profile) {
+        TCGv_ptr ptr = tcg_constant_ptr(&db->tb->profile->exec_count);
+        TCGv_ptr n = tcg_temp_new_ptr();
+
+        tcg_gen_ld_ptr(n, ptr, 0);
+        tcg_gen_addi_ptr(n, n, 1);
+        tcg_gen_st_ptr(n, ptr, 0);
+    }
+
     return icount_start_insn;
 }
 
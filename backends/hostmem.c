@@ -257,6 +257,27 @@ static void host_memory_backend_set_prealloc(Object *obj, bool value,
     }
 }
 
+static bool host_memory_backend_get_prealloc_background(Object *obj,
+                                                       Error **errp)
+{
+    HostMemoryBackend *backend = MEMORY_BACKEND(obj);
+
+    return backend->prealloc_background;
+}
+
+static void host_memory_backend_set_prealloc_background(Object *obj,
+                                                        bool value,
+                                                        Error **errp)
+{
+    HostMemoryBackend *backend = MEMORY_BACKEND(obj);
+
+    if (host_memory_backend_mr_inited(backend)) {
+        error_setg(errp, "cannot change property value");
+        return;
+    }
+    backend->prealloc_background = value;
+}
+
 static void host_memory_backend_get_prealloc_threads(Object *obj, Visitor *v,
     const char *name, void *opaque, Error **errp)
 {
@@ -423,6 +444,13 @@ host_memory_backend_memory_complete(UserCreatable *uc, Error **errp)
      * This is necessary to guarantee memory is allocated with
      * specified NUMA policy in place.
      */
+    if (backend->prealloc && backend->prealloc_background) {
+        qemu_prealloc_mem_background(memory_region_get_fd(&backend->mr),
+                                     ptr, sz, backend->prealloc_threads,
+                                     backend->prealloc_context,
+                                     &backend->prealloc_job, errp);
+        return;
+    }
     if (backend->prealloc && !qemu_prealloc_mem(memory_region_get_fd(&backend->mr),
                                                 ptr, sz,
                                                 backend->prealloc_threads,
@@ -432,6 +460,33 @@ host_memory_backend_memory_complete(UserCreatable *uc, Error **errp)
     }
 }
 
+bool host_memory_backend_get_prealloc_progress(HostMemoryBackend *backend,
+                                               uint64_t *done)
+{
+    if (!backend->prealloc || !backend->prealloc_background ||
+        !host_memory_backend_mr_inited(backend)) {
+        return false;
+    }
+
+    /* Without a job, the memory was preallocated synchronously. */
+    *done = backend->prealloc_job ?
+            qemu_prealloc_job_done(backend->prealloc_job) :
+            memory_region_size(&backend->mr);
+    return true;
+}
+
+static void host_memory_backend_unparent(Object *obj)
+{
+    HostMemoryBackend *backend = MEMORY_BACKEND(obj);
+
+    /*
+     * The RAM goes away with our children, before instance_finalize runs,
+     * so stop populating it as soon as the backend is deleted.
+     */
+    qemu_prealloc_job_free(backend->prealloc_job);
+    backend->prealloc_job = NULL;
+}
+
 static bool
 host_memory_backend_can_be_deleted(UserCreatable *uc)
 {
@@ -508,6 +563,7 @@ host_memory_backend_class_init(ObjectClass *oc, const void *data)
 
     ucc->complete = host_memory_backend_memory_complete;
     ucc->can_be_deleted = host_memory_backend_can_be_deleted;
+    oc->unparent = host_memory_backend_unparent;
 
     object_class_property_add_bool(oc, "merge",
         host_memory_backend_get_merge,
@@ -535,6 +591,11 @@ host_memory_backend_class_init(ObjectClass *oc, const void *data)
         object_property_allow_set_link, OBJ_PROP_LINK_STRONG);
     object_class_property_set_description(oc, "prealloc-context",
         "Context to use for creating CPU threads for preallocation");
+    object_class_property_add_bool(oc, "prealloc-background",
+        host_memory_backend_get_prealloc_background,
+        host_memory_backend_set_prealloc_background);
+    object_class_property_set_description(oc, "prealloc-background",
+        "Preallocate memory while the guest is already running");
     object_class_property_add(oc, "size", "int",
         host_memory_backend_get_size,
         host_memory_backend_set_size,
@@ -20,7 +20,6 @@ static enum qemu_plugin_mem_rw rw = QEMU_PLUGIN_MEM_RW;
 static GHashTable *miss_ht;
 
 static GMutex hashtable_lock;
-static GRand *rng;
 
 static int limit;
 static bool sys;
@@ -78,6 +77,7 @@ typedef struct {
     uint64_t tag_mask;
     uint64_t accesses;
     uint64_t misses;
+    GRand *rng;
 } Cache;
 
 typedef struct {
@@ -87,8 +87,44 @@ typedef struct {
     uint64_t l1_dmisses;
     uint64_t l1_imisses;
     uint64_t l2_misses;
+    uint64_t l3_misses;
+    uint64_t tlb_misses;
 } InsnData;
 
+/*
+ * A memory access to be simulated. @addr is used for the caches,
+ * @vaddr for the TLB.
+ */
+typedef struct {
+    uint64_t addr;
+    uint64_t vaddr;
+    InsnData *insn;
+    bool fetch;
+} MemRecord;
+
+/*
+ * With offload=on, vCPUs do not simulate the caches themselves: each
+ * vCPU appends its accesses to its own ring, and one worker thread per
+ * simulated core replays the rings of the vCPUs mapped to that core.
+ * A ring has a single producer and a single consumer, so it needs no
+ * lock; the vCPU only waits when the worker has fallen a whole ring
+ * behind.
+ */
+#define RING_SIZE (1 << 14)
+
+typedef struct {
+    MemRecord *buf;
+    /* Written by the vCPU */
+    uint64_t head;
+    /* Keep the two indices in separate host cache lines */
+    char pad[64 - sizeof(uint64_t)];
+    /* Written by the worker */
+    uint64_t tail;
+} Ring;
+
+/* vCPUs beyond the last ring simulate in their own thread */
+#define USER_MAX_RINGS 1024
+
 void (*update_hit)(Cache *cache, int set, int blk);
 void (*update_miss)(Cache *cache, int set, int blk);
 
@@ -101,9 +137,22 @@ static Cache **l1_dcaches, **l1_icaches;
 static bool use_l2;
 static Cache **l2_ucaches;
 
-static GMutex *l1_dcache_locks;
-static GMutex *l1_icache_locks;
-static GMutex *l2_ucache_locks;
+/* The L3 cache is shared by all cores */
+static bool use_l3;
+static Cache *l3_ucache;
+static GMutex l3_ucache_lock;
+
+static bool use_tlb;
+static Cache **dtlbs;
+
+/* Protects the per-core caches and TLB */
+static GMutex *core_locks;
+
+static bool offload;
+static Ring *rings;
+static int nr_rings;
+static GThread **workers;
+static bool workers_stop;
 
 static uint64_t l1_dmem_accesses;
 static uint64_t l1_imem_accesses;
@@ -113,6 +162,9 @@ static uint64_t l1_dmisses;
 static uint64_t l2_mem_accesses;
 static uint64_t l2_misses;
 
+static uint64_t tlb_accesses;
+static uint64_t tlb_misses;
+
 static int pow_of_two(int num)
 {
     g_assert((num & (num - 1)) == 0);
@@ -266,6 +318,7 @@ static Cache *cache_init(int blksize, int assoc, int cachesize)
     cache->blksize_shift = pow_of_two(blksize);
     cache->accesses = 0;
     cache->misses = 0;
+    cache->rng = policy == RAND ? g_rand_new() : NULL;
 
     for (i = 0; i < cache->num_sets; i++) {
         cache->sets[i].blocks = g_new0(CacheBlock, assoc);
@@ -317,7 +370,7 @@ static int get_replaced_block(Cache *cache, int set)
 {
     switch (policy) {
     case RAND:
-        return g_rand_int_range(rng, 0, cache->assoc);
+        return g_rand_int_range(cache->rng, 0, cache->assoc);
     case LRU:
         return lru_get_lru_block(cache, set);
     case FIFO:
@@ -385,81 +438,200 @@ static bool access_cache(Cache *cache, uint64_t addr)
     return false;
 }
 
-static void vcpu_mem_access(unsigned int vcpu_index, qemu_plugin_meminfo_t info,
-                            uint64_t vaddr, void *userdata)
+static void count_miss(uint64_t *counter)
 {
-    uint64_t effective_addr;
-    struct qemu_plugin_hwaddr *hwaddr;
-    int cache_idx;
-    InsnData *insn;
-    bool hit_in_l1;
+    __atomic_fetch_add(counter, 1, __ATOMIC_SEQ_CST);
+}
 
-    hwaddr = qemu_plugin_get_hwaddr(info, vaddr);
-    if (hwaddr && qemu_plugin_hwaddr_is_io(hwaddr)) {
+/*
+ * simulate_access(): Run an access through the hierarchy of a core
+ * @cache_idx: The core, whose lock must be held
+ * @rec: The access
+ */
+static void simulate_access(int cache_idx, const MemRecord *rec)
+{
+    Cache *l1, *l2;
+    bool hit_in_l3;
+
+    if (use_tlb && !rec->fetch) {
+        if (!access_cache(dtlbs[cache_idx], rec->vaddr)) {
+            count_miss(&rec->insn->tlb_misses);
+            dtlbs[cache_idx]->misses++;
+        }
+        dtlbs[cache_idx]->accesses++;
+    }
+
+    l1 = rec->fetch ? l1_icaches[cache_idx] : l1_dcaches[cache_idx];
+    l1->accesses++;
+    if (access_cache(l1, rec->addr)) {
         return;
     }
+    l1->misses++;
+    count_miss(rec->fetch ? &rec->insn->l1_imisses : &rec->insn->l1_dmisses);
 
-    effective_addr = hwaddr ? qemu_plugin_hwaddr_phys_addr(hwaddr) : vaddr;
-    cache_idx = vcpu_index % cores;
+    if (!use_l2) {
+        return;
+    }
 
-    g_mutex_lock(&l1_dcache_locks[cache_idx]);
-    hit_in_l1 = access_cache(l1_dcaches[cache_idx], effective_addr);
-    if (!hit_in_l1) {
-        insn = userdata;
-        __atomic_fetch_add(&insn->l1_dmisses, 1, __ATOMIC_SEQ_CST);
-        l1_dcaches[cache_idx]->misses++;
+    l2 = l2_ucaches[cache_idx];
+    l2->accesses++;
+    if (access_cache(l2, rec->addr)) {
+        return;
     }
-    l1_dcaches[cache_idx]->accesses++;
-    g_mutex_unlock(&l1_dcache_locks[cache_idx]);
+    l2->misses++;
+    count_miss(&rec->insn->l2_misses);
 
-    if (hit_in_l1 || !use_l2) {
-        /* No need to access L2 */
+    if (!use_l3) {
         return;
     }
 
-    g_mutex_lock(&l2_ucache_locks[cache_idx]);
-    if (!access_cache(l2_ucaches[cache_idx], effective_addr)) {
-        insn = userdata;
-        __atomic_fetch_add(&insn->l2_misses, 1, __ATOMIC_SEQ_CST);
-        l2_ucaches[cache_idx]->misses++;
+    g_mutex_lock(&l3_ucache_lock);
+    hit_in_l3 = access_cache(l3_ucache, rec->addr);
+    if (!hit_in_l3) {
+        l3_ucache->misses++;
+    }
+    l3_ucache->accesses++;
+    g_mutex_unlock(&l3_ucache_lock);
+
+    if (!hit_in_l3) {
+        count_miss(&rec->insn->l3_misses);
     }
-    l2_ucaches[cache_idx]->accesses++;
-    g_mutex_unlock(&l2_ucache_locks[cache_idx]);
 }
 
-static void vcpu_insn_exec(unsigned int vcpu_index, void *userdata)
+static void ring_push(Ring *ring, const MemRecord *rec)
 {
-    uint64_t insn_addr;
-    InsnData *insn;
-    int cache_idx;
-    bool hit_in_l1;
+    uint64_t head = ring->head;
+
+    if (!ring->buf) {
+        __atomic_store_n(&ring->buf, g_new(MemRecord, RING_SIZE),
+                         __ATOMIC_RELEASE);
+    }
+    while (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) ==
+           RING_SIZE) {
+        g_thread_yield();
+    }
 
-    insn_addr = ((InsnData *) userdata)->addr;
+    ring->buf[head & (RING_SIZE - 1)] = *rec;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/* Replay what is in @ring, returning false if it was empty. */
+static bool ring_drain(Ring *ring, int cache_idx)
+{
+    MemRecord *buf = __atomic_load_n(&ring->buf, __ATOMIC_ACQUIRE);
+    uint64_t tail = ring->tail;
+    uint64_t head;
+
+    if (!buf) {
+        return false;
+    }
+    head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+        return false;
+    }
+
+    g_mutex_lock(&core_locks[cache_idx]);
+    for (; tail != head; tail++) {
+        simulate_access(cache_idx, &buf[tail & (RING_SIZE - 1)]);
+    }
+    g_mutex_unlock(&core_locks[cache_idx]);
+
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    return true;
+}
+
+static gpointer worker_thread(gpointer opaque)
+{
+    int cache_idx = GPOINTER_TO_INT(opaque);
+
+    for (;;) {
+        /* Read the flag first, so that a final pass sees every record. */
+        bool stop = __atomic_load_n(&workers_stop, __ATOMIC_ACQUIRE);
+        bool idle = true;
+        int i;
+
+        for (i = cache_idx; i < nr_rings; i += cores) {
+            if (ring_drain(&rings[i], cache_idx)) {
+                idle = false;
+            }
+        }
+        if (idle) {
+            if (stop) {
+                return NULL;
+            }
+            g_usleep(100);
+        }
+    }
+}
 
-    cache_idx = vcpu_index % cores;
-    g_mutex_lock(&l1_icache_locks[cache_idx]);
-    hit_in_l1 = access_cache(l1_icaches[cache_idx], insn_addr);
-    if (!hit_in_l1) {
-        insn = userdata;
-        __atomic_fetch_add(&insn->l1_imisses, 1, __ATOMIC_SEQ_CST);
-        l1_icaches[cache_idx]->misses++;
+static void workers_init(void)
+{
+    int i;
+
+    rings = g_new0(Ring, nr_rings);
+    workers = g_new(GThread *, cores);
+    for (i = 0; i < cores; i++) {
+        workers[i] = g_thread_new("cache-sim", worker_thread,
+                                  GINT_TO_POINTER(i));
+    }
+}
+
+static void workers_finish(void)
+{
+    int i;
+
+    __atomic_store_n(&workers_stop, true, __ATOMIC_RELEASE);
+    for (i = 0; i < cores; i++) {
+        g_thread_join(workers[i]);
+    }
+    for (i = 0; i < nr_rings; i++) {
+        g_free(rings[i].buf);
     }
-    l1_icaches[cache_idx]->accesses++;
-    g_mutex_unlock(&l1_icache_locks[cache_idx]);
+    g_free(workers);
+    g_free(rings);
+}
+
+static void submit_access(unsigned int vcpu_index, const MemRecord *rec)
+{
+    int cache_idx = vcpu_index % cores;
 
-    if (hit_in_l1 || !use_l2) {
-        /* No need to access L2 */
+    if (offload && vcpu_index < nr_rings) {
+        ring_push(&rings[vcpu_index], rec);
         return;
     }
 
-    g_mutex_lock(&l2_ucache_locks[cache_idx]);
-    if (!access_cache(l2_ucaches[cache_idx], insn_addr)) {
-        insn = userdata;
-        __atomic_fetch_add(&insn->l2_misses, 1, __ATOMIC_SEQ_CST);
-        l2_ucaches[cache_idx]->misses++;
+    g_mutex_lock(&core_locks[cache_idx]);
+    simulate_access(cache_idx, rec);
+    g_mutex_unlock(&core_locks[cache_idx]);
+}
+
+static void vcpu_mem_access(unsigned int vcpu_index, qemu_plugin_meminfo_t info,
+                            uint64_t vaddr, void *userdata)
+{
+    struct qemu_plugin_hwaddr *hwaddr;
+    MemRecord rec;
+
+    hwaddr = qemu_plugin_get_hwaddr(info, vaddr);
+    if (hwaddr && qemu_plugin_hwaddr_is_io(hwaddr)) {
+        return;
     }
-    l2_ucaches[cache_idx]->accesses++;
-    g_mutex_unlock(&l2_ucache_locks[cache_idx]);
+
+    rec.addr = hwaddr ? qemu_plugin_hwaddr_phys_addr(hwaddr) : vaddr;
+    rec.vaddr = vaddr;
+    rec.insn = userdata;
+    rec.fetch = false;
+    submit_access(vcpu_index, &rec);
+}
+
+static void vcpu_insn_exec(unsigned int vcpu_index, void *userdata)
+{
+    MemRecord rec;
+
+    rec.insn = userdata;
+    rec.addr = rec.insn->addr;
+    rec.vaddr = rec.insn->addr;
+    rec.fetch = true;
+    submit_access(vcpu_index, &rec);
 }
 
 static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
@@ -516,6 +688,9 @@ static void cache_free(Cache *cache)
         metadata_destroy(cache);
     }
 
+    if (cache->rng) {
+        g_rand_free(cache->rng);
+    }
     g_free(cache->sets);
     g_free(cache);
 }
@@ -532,7 +707,8 @@ static void caches_free(Cache **caches)
 static void append_stats_line(GString *line,
                               uint64_t l1_daccess, uint64_t l1_dmisses,
                               uint64_t l1_iaccess, uint64_t l1_imisses,
-                              uint64_t l2_access, uint64_t l2_misses)
+                              uint64_t l2_access, uint64_t l2_misses,
+                              uint64_t tlb_access, uint64_t tlb_misses)
 {
     double l1_dmiss_rate = ((double) l1_dmisses) / (l1_daccess) * 100.0;
     double l1_imiss_rate = ((double) l1_imisses) / (l1_iaccess) * 100.0;
@@ -555,6 +731,15 @@ static void append_stats_line(GString *line,
                                l2_miss_rate);
     }
 
+    if (use_tlb) {
+        double tlb_miss_rate = ((double) tlb_misses) / (tlb_access) * 100.0;
+        g_string_append_printf(line,
+                               "  %-13" PRIu64 " %-11" PRIu64 " %11.4lf%%",
+                               tlb_access,
+                               tlb_misses,
+                               tlb_access ? tlb_miss_rate : 0.0);
+    }
+
     g_string_append(line, "\n");
 }
 
@@ -573,6 +758,11 @@ static void sum_stats(void)
             l2_misses += l2_ucaches[i]->misses;
             l2_mem_accesses += l2_ucaches[i]->accesses;
         }
+
+        if (use_tlb) {
+            tlb_misses += dtlbs[i]->misses;
+            tlb_accesses += dtlbs[i]->accesses;
+        }
     }
 }
 
@@ -600,10 +790,26 @@ static int l2_cmp(gconstpointer a, gconstpointer b, gpointer d)
     return insn_a->l2_misses < insn_b->l2_misses ? 1 : -1;
 }
 
+static int l3_cmp(gconstpointer a, gconstpointer b, gpointer d)
+{
+    InsnData *insn_a = (InsnData *) a;
+    InsnData *insn_b = (InsnData *) b;
+
+    return insn_a->l3_misses < insn_b->l3_misses ? 1 : -1;
+}
+
+static int tlb_cmp(gconstpointer a, gconstpointer b, gpointer d)
+{
+    InsnData *insn_a = (InsnData *) a;
+    InsnData *insn_b = (InsnData *) b;
+
+    return insn_a->tlb_misses < insn_b->tlb_misses ? 1 : -1;
+}
+
 static void log_stats(void)
 {
     int i;
-    Cache *icache, *dcache, *l2_cache = NULL;
+    Cache *icache, *dcache, *l2_cache = NULL, *tlb;
 
     g_autoptr(GString) rep = g_string_new("core #, data accesses, data misses,"
                                           " dmiss rate, insn accesses,"
@@ -613,6 +819,10 @@ static void log_stats(void)
         g_string_append(rep, ", l2 accesses, l2 misses, l2 miss rate");
     }
 
+    if (use_tlb) {
+        g_string_append(rep, ", tlb accesses, tlb misses, tlb miss rate");
+    }
+
     g_string_append(rep, "\n");
 
     for (i = 0; i < cores; i++) {
@@ -620,10 +830,13 @@ static void log_stats(void)
         dcache = l1_dcaches[i];
         icache = l1_icaches[i];
         l2_cache = use_l2 ? l2_ucaches[i] : NULL;
+        tlb = use_tlb ? dtlbs[i] : NULL;
         append_stats_line(rep, dcache->accesses, dcache->misses,
                 icache->accesses, icache->misses,
                 l2_cache ? l2_cache->accesses : 0,
-                l2_cache ? l2_cache->misses : 0);
+                l2_cache ? l2_cache->misses : 0,
+                tlb ? tlb->accesses : 0,
+                tlb ? tlb->misses : 0);
     }
 
     if (cores > 1) {
@@ -631,7 +844,17 @@ static void log_stats(void)
         g_string_append_printf(rep, "%-8s", "sum");
         append_stats_line(rep, l1_dmem_accesses, l1_dmisses,
                 l1_imem_accesses, l1_imisses,
-                l2_cache ? l2_mem_accesses : 0, l2_cache ? l2_misses : 0);
+                l2_cache ? l2_mem_accesses : 0, l2_cache ? l2_misses : 0,
+                tlb_accesses, tlb_misses);
+    }
+
+    if (use_l3) {
+        g_string_append_printf(rep, "\nshared l3: %" PRIu64 " accesses, %"
+                               PRIu64 " misses, %.4lf%% miss rate\n",
+                               l3_ucache->accesses, l3_ucache->misses,
+                               l3_ucache->accesses ?
+                               (double) l3_ucache->misses /
+                               l3_ucache->accesses * 100.0 : 0.0);
     }
 
     g_string_append(rep, "\n");
@@ -672,6 +895,23 @@ static void log_top_insns(void)
                                insn->l1_imisses, insn->disas_str);
     }
 
+    if (use_tlb) {
+        miss_insns = g_list_sort_with_data(miss_insns, tlb_cmp, NULL);
+        g_string_append_printf(rep, "%s",
+                               "\naddress, TLB misses, instruction\n");
+
+        for (curr = miss_insns, i = 0; curr && i < limit;
+             i++, curr = curr->next) {
+            insn = (InsnData *) curr->data;
+            g_string_append_printf(rep, "0x%" PRIx64, insn->addr);
+            if (insn->symbol) {
+                g_string_append_printf(rep, " (%s)", insn->symbol);
+            }
+            g_string_append_printf(rep, ", %" PRId64 ", %s\n",
+                                   insn->tlb_misses, insn->disas_str);
+        }
+    }
+
     if (!use_l2) {
         goto finish;
     }
@@ -689,6 +929,23 @@ static void log_top_insns(void)
                                insn->l2_misses, insn->disas_str);
     }
 
+    if (!use_l3) {
+        goto finish;
+    }
+
+    miss_insns = g_list_sort_with_data(miss_insns, l3_cmp, NULL);
+    g_string_append_printf(rep, "%s", "\naddress, L3 misses, instruction\n");
+
+    for (curr = miss_insns, i = 0; curr && i < limit; i++, curr = curr->next) {
+        insn = (InsnData *) curr->data;
+        g_string_append_printf(rep, "0x%" PRIx64, insn->addr);
+        if (insn->symbol) {
+            g_string_append_printf(rep, " (%s)", insn->symbol);
+        }
+        g_string_append_printf(rep, ", %" PRId64 ", %s\n",
+                               insn->l3_misses, insn->disas_str);
+    }
+
 finish:
     qemu_plugin_outs(rep->str);
     g_list_free(miss_insns);
@@ -696,18 +953,28 @@ finish:
 
 static void plugin_exit(qemu_plugin_id_t id, void *p)
 {
+    if (offload) {
+        workers_finish();
+    }
+
     log_stats();
     log_top_insns();
 
     caches_free(l1_dcaches);
     caches_free(l1_icaches);
 
-    g_free(l1_dcache_locks);
-    g_free(l1_icache_locks);
+    g_free(core_locks);
 
     if (use_l2) {
         caches_free(l2_ucaches);
-        g_free(l2_ucache_locks);
+    }
+
+    if (use_l3) {
+        cache_free(l3_ucache);
+    }
+
+    if (use_tlb) {
+        caches_free(dtlbs);
     }
 
     g_hash_table_destroy(miss_ht);
@@ -728,7 +995,6 @@ static void policy_init(void)
         metadata_destroy = fifo_destroy;
         break;
     case RAND:
-        rng = g_rand_new();
         break;
     default:
         g_assert_not_reached();
@@ -743,6 +1009,9 @@ int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
     int l1_iassoc, l1_iblksize, l1_icachesize;
     int l1_dassoc, l1_dblksize, l1_dcachesize;
     int l2_assoc, l2_blksize, l2_cachesize;
+    int l3_assoc, l3_blksize, l3_cachesize;
+    int tlb_assoc, tlb_entries, tlb_pagesize;
+    bool l2_off = false;
 
     limit = 32;
     sys = info->system_emulation;
@@ -759,6 +1028,14 @@ int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
     l2_blksize = 64;
     l2_cachesize = l2_assoc * l2_blksize * 2048;
 
+    l3_assoc = 16;
+    l3_blksize = 64;
+    l3_cachesize = l3_assoc * l3_blksize * 8192;
+
+    tlb_assoc = 4;
+    tlb_entries = 64;
+    tlb_pagesize = 4096;
+
     policy = LRU;
 
     cores = sys ? info->system.smp_vcpus : 1;
@@ -797,6 +1074,40 @@ int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
                 fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
                 return -1;
             }
+            l2_off = !use_l2;
+        } else if (g_strcmp0(tokens[0], "l3cachesize") == 0) {
+            use_l3 = true;
+            l3_cachesize = STRTOLL(tokens[1]);
+        } else if (g_strcmp0(tokens[0], "l3blksize") == 0) {
+            use_l3 = true;
+            l3_blksize = STRTOLL(tokens[1]);
+        } else if (g_strcmp0(tokens[0], "l3assoc") == 0) {
+            use_l3 = true;
+            l3_assoc = STRTOLL(tokens[1]);
+        } else if (g_strcmp0(tokens[0], "l3") == 0) {
+            if (!qemu_plugin_bool_parse(tokens[0], tokens[1], &use_l3)) {
+                fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
+                return -1;
+            }
+        } else if (g_strcmp0(tokens[0], "tlbentries") == 0) {
+            use_tlb = true;
+            tlb_entries = STRTOLL(tokens[1]);
+        } else if (g_strcmp0(tokens[0], "tlbassoc") == 0) {
+            use_tlb = true;
+            tlb_assoc = STRTOLL(tokens[1]);
+        } else if (g_strcmp0(tokens[0], "tlbpagesize") == 0) {
+            use_tlb = true;
+            tlb_pagesize = STRTOLL(tokens[1]);
+        } else if (g_strcmp0(tokens[0], "tlb") == 0) {
+            if (!qemu_plugin_bool_parse(tokens[0], tokens[1], &use_tlb)) {
+                fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
+                return -1;
+            }
+        } else if (g_strcmp0(tokens[0], "offload") == 0) {
+            if (!qemu_plugin_bool_parse(tokens[0], tokens[1], &offload)) {
+                fprintf(stderr, "boolean argument parsing failed: %s\n", opt);
+                return -1;
+            }
         } else if (g_strcmp0(tokens[0], "evict") == 0) {
             if (g_strcmp0(tokens[1], "rand") == 0) {
                 policy = RAND;
@@ -832,6 +1143,12 @@ int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
         return -1;
     }
 
+    /* The L3 cache is only looked up on L2 misses */
+    if (use_l3 && !use_l2 && l2_off) {
+        fprintf(stderr, "L3 cache cannot be used without an L2 cache\n");
+        return -1;
+    }
+    use_l2 |= use_l3;
     l2_ucaches = use_l2 ? caches_init(l2_blksize, l2_assoc, l2_cachesize) : NULL;
     if (!l2_ucaches && use_l2) {
         const char *err = cache_config_error(l2_blksize, l2_assoc, l2_cachesize);
@@ -840,9 +1157,35 @@ int qemu_plugin_install(qemu_plugin_id_t id, const qemu_info_t *info,
         return -1;
     }
 
-    l1_dcache_locks = g_new0(GMutex, cores);
-    l1_icache_locks = g_new0(GMutex, cores);
-    l2_ucache_locks = use_l2 ? g_new0(GMutex, cores) : NULL;
+    if (use_l3) {
+        if (bad_cache_params(l3_blksize, l3_assoc, l3_cachesize)) {
+            const char *err = cache_config_error(l3_blksize, l3_assoc,
+                                                 l3_cachesize);
+            fprintf(stderr, "L3 cache cannot be constructed from given "
+                    "parameters\n");
+            fprintf(stderr, "%s\n", err);
+            return -1;
+        }
+        l3_ucache = cache_init(l3_blksize, l3_assoc, l3_cachesize);
+    }
+
+    /* A TLB is a cache whose blocks are pages */
+    dtlbs = use_tlb ? caches_init(tlb_pagesize, tlb_assoc,
+                                  tlb_entries * tlb_pagesize) : NULL;
+    if (!dtlbs && use_tlb) {
+        const char *err = cache_config_error(tlb_pagesize, tlb_assoc,
+                                             tlb_entries * tlb_pagesize);
+        fprintf(stderr, "TLB cannot be constructed from given parameters\n");
+        fprintf(stderr, "%s\n", err);
+        return -1;
+    }
+
+    core_locks = g_new0(GMutex, cores);
+
+    if (offload) {
+        nr_rings = sys ? info->system.max_vcpus : USER_MAX_RINGS;
+        workers_init();
+    }
 
     qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
     qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
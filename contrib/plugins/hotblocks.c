@@ -17,7 +17,7 @@
 
 QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
 
-static bool do_inline;
+static bool do_inline = true;
 
 /* Plugins need to take care of their own locking */
 static GMutex lock;
@@ -37,17 +37,22 @@ typedef struct {
     struct qemu_plugin_scoreboard *exec_count;
     int trans_count;
     unsigned long insns;
+    /* Sum of the per-vCPU exec_count, filled in for the report */
+    uint64_t total;
 } ExecCount;
 
 static gint cmp_exec_count(gconstpointer a, gconstpointer b, gpointer d)
 {
     ExecCount *ea = (ExecCount *) a;
     ExecCount *eb = (ExecCount *) b;
-    uint64_t count_a =
-        qemu_plugin_u64_sum(qemu_plugin_scoreboard_u64(ea->exec_count));
-    uint64_t count_b =
-        qemu_plugin_u64_sum(qemu_plugin_scoreboard_u64(eb->exec_count));
-    return count_a > count_b ? -1 : 1;
+    return ea->total > eb->total ? -1 : 1;
+}
+
+static void exec_count_merge(gpointer data, gpointer user_data)
+{
+    ExecCount *cnt = data;
+    cnt->total =
+        qemu_plugin_u64_sum(qemu_plugin_scoreboard_u64(cnt->exec_count));
 }
 
 static guint exec_count_hash(gconstpointer v)
@@ -79,6 +84,7 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
     g_string_append_printf(report, "%d entries in the hash table\n",
                            g_hash_table_size(hotblocks));
     counts = g_hash_table_get_values(hotblocks);
+    g_list_foreach(counts, exec_count_merge, NULL);
     sorted_counts = g_list_sort_with_data(counts, cmp_exec_count, NULL);
 
     if (sorted_counts) {
@@ -90,9 +96,7 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
             g_string_append_printf(
                 report, "0x%016"PRIx64", %d, %ld, %"PRIu64"\n",
                 rec->start_addr, rec->trans_count,
-                rec->insns,
-                qemu_plugin_u64_sum(
-                    qemu_plugin_scoreboard_u64(rec->exec_count)));
+                rec->insns, rec->total);
         }
 
         g_list_free(sorted_counts);
@@ -117,8 +121,10 @@ static void vcpu_tb_exec(unsigned int cpu_index, void *udata)
 }
 
 /*
- * When do_inline we ask the plugin to increment the counter for us.
- * Otherwise a helper is inserted which calls the vcpu_tb_exec
+ * When do_inline (the default) we ask the plugin to increment the
+ * counter for us; every vCPU has its own slot in the scoreboard so no
+ * locking is needed at execution time and only translation takes the
+ * lock. Otherwise a helper is inserted which calls the vcpu_tb_exec
  * callback.
  */
 static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
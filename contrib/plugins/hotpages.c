@@ -45,8 +45,18 @@ typedef struct {
     uint64_t writes;
 } PageCounters;
 
-static GMutex lock;
-static GHashTable *pages;
+/*
+ * Each vCPU counts into its own table, so the memory callback needs
+ * no locking; the tables are only merged for the final report. Most
+ * accesses hit the same page as the previous one, so keep that entry
+ * at hand and skip the hash lookup.
+ */
+typedef struct {
+    GHashTable *pages;
+    PageCounters *last;
+} VCPUPages;
+
+static struct qemu_plugin_scoreboard *vcpu_pages;
 
 static gint cmp_access_count(gconstpointer a, gconstpointer b, gpointer d)
 {
@@ -73,9 +83,51 @@ static gint cmp_access_count(gconstpointer a, gconstpointer b, gpointer d)
 }
 
 
+static GHashTable *merge_pages(void)
+{
+    GHashTable *pages = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                              NULL, g_free);
+
+    for (int i = 0; i < qemu_plugin_num_vcpus(); i++) {
+        VCPUPages *vp = qemu_plugin_scoreboard_find(vcpu_pages, i);
+        GHashTableIter iter;
+        gpointer value;
+
+        if (!vp->pages) {
+            continue;
+        }
+        g_hash_table_iter_init(&iter, vp->pages);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            PageCounters *src = value;
+            PageCounters *dst = g_hash_table_lookup(pages,
+                                                    &src->page_address);
+
+            if (!dst) {
+                dst = g_new0(PageCounters, 1);
+                dst->page_address = src->page_address;
+                g_hash_table_insert(pages, &dst->page_address, dst);
+            }
+            if (src->reads) {
+                dst->reads += src->reads;
+                dst->cpu_read |= (1 << i);
+            }
+            if (src->writes) {
+                dst->writes += src->writes;
+                dst->cpu_write |= (1 << i);
+            }
+        }
+        g_hash_table_destroy(vp->pages);
+        vp->pages = NULL;
+        vp->last = NULL;
+    }
+
+    return pages;
+}
+
 static void plugin_exit(qemu_plugin_id_t id, void *p)
 {
     g_autoptr(GString) report = g_string_new("Addr, RCPUs, Reads, WCPUs, Writes\n");
+    g_autoptr(GHashTable) pages = merge_pages();
     int i;
     GList *counts;
 
@@ -98,18 +150,20 @@ static void plugin_exit(qemu_plugin_id_t id, void *p)
     }
 
     qemu_plugin_outs(report->str);
+    qemu_plugin_scoreboard_free(vcpu_pages);
 }
 
 static void plugin_init(void)
 {
     page_mask = (page_size - 1);
-    pages = g_hash_table_new(g_int64_hash, g_int64_equal);
+    vcpu_pages = qemu_plugin_scoreboard_new(sizeof(VCPUPages));
 }
 
 static void vcpu_haddr(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
                        uint64_t vaddr, void *udata)
 {
     struct qemu_plugin_hwaddr *hwaddr = qemu_plugin_get_hwaddr(meminfo, vaddr);
+    VCPUPages *vp = qemu_plugin_scoreboard_find(vcpu_pages, cpu_index);
     uint64_t page;
     PageCounters *count;
 
@@ -129,23 +183,26 @@ static void vcpu_haddr(unsigned int cpu_index, qemu_plugin_meminfo_t meminfo,
     }
     page &= ~page_mask;
 
-    g_mutex_lock(&lock);
-    count = (PageCounters *) g_hash_table_lookup(pages, &page);
-
-    if (!count) {
-        count = g_new0(PageCounters, 1);
-        count->page_address = page;
-        g_hash_table_insert(pages, &count->page_address, count);
+    count = vp->last;
+    if (!count || count->page_address != page) {
+        if (!vp->pages) {
+            vp->pages = g_hash_table_new_full(g_int64_hash, g_int64_equal,
+                                              NULL, g_free);
+        }
+        count = (PageCounters *) g_hash_table_lookup(vp->pages, &page);
+        if (!count) {
+            count = g_new0(PageCounters, 1);
+            count->page_address = page;
+            g_hash_table_insert(vp->pages, &count->page_address, count);
+        }
+        vp->last = count;
     }
+
     if (qemu_plugin_mem_is_store(meminfo)) {
         count->writes++;
-        count->cpu_write |= (1 << cpu_index);
     } else {
         count->reads++;
-        count->cpu_read |= (1 << cpu_index);
     }
-
-    g_mutex_unlock(&lock);
 }
 
 static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
@@ -81,6 +81,7 @@ this code that are retained.
 
 #include "qemu/osdep.h"
 #include <math.h>
+#include <float.h>
 #include "qemu/bitops.h"
 #include "fpu/softfloat.h"
 
@@ -396,6 +397,133 @@ float64_gen2(float64 xa, float64 xb, float_status *s,
     return soft(ua.s, ub.s, s);
 }
 
+/*
+ * floatx80 hardfloat.  The guest's rounding precision picks the host
+ * type.  Full extended precision needs a host whose long double is the
+ * x87 80-bit format.  Double precision can use the host double on any
+ * host, provided both inputs convert exactly to normal doubles and the
+ * result is a normal double: rounding to 53 bits then cannot depend on
+ * the wider floatx80 exponent range.  Everything else, including single
+ * precision, goes to soft-fp.  Windows hosts are excluded since their
+ * default x87 control word does not round long double to 64 bits.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(_WIN32) && \
+    LDBL_MANT_DIG == 64
+# define QEMU_HARDFLOAT_FX80_USE_LD 1
+#else
+# define QEMU_HARDFLOAT_FX80_USE_LD 0
+#endif
+
+typedef union {
+    floatx80 s;
+    long double h;
+} union_floatx80;
+
+typedef bool (*fx80_check_fn)(floatx80 a, floatx80 b);
+typedef floatx80 (*soft_fx80_op2_fn)(floatx80 a, floatx80 b, float_status *s);
+typedef long double (*hard_fx80_op2_fn)(long double a, long double b);
+
+/* Unnormals and pseudo-denormals are neither. */
+static inline bool fx80_is_zero_or_normal(floatx80 a)
+{
+    int exp = a.high & 0x7fff;
+
+    if (exp == 0) {
+        return a.low == 0;
+    }
+    return exp != 0x7fff && (a.low >> 63);
+}
+
+static inline bool fx80_is_zon2(floatx80 a, floatx80 b)
+{
+    return fx80_is_zero_or_normal(a) && fx80_is_zero_or_normal(b);
+}
+
+/* Convert a zero or normal floatx80 to a double, if that is exact. */
+static inline bool fx80_to_f64_exact(floatx80 a, union_float64 *r)
+{
+    uint64_t sign = (uint64_t)(a.high >> 15) << 63;
+    int exp = a.high & 0x7fff;
+
+    if (exp == 0) {
+        r->s = make_float64(sign);
+        return true;
+    }
+    exp += 1023 - 0x3fff;
+    if (exp <= 0 || exp >= 0x7ff || extract64(a.low, 0, 11)) {
+        return false;
+    }
+    r->s = make_float64(sign | ((uint64_t)exp << 52) |
+                        extract64(a.low, 11, 52));
+    return true;
+}
+
+/* Convert a zero or normal double to floatx80. */
+static inline floatx80 f64_to_fx80(union_float64 a)
+{
+    uint64_t bits = float64_val(a.s);
+    uint16_t high = extract64(bits, 63, 1) << 15;
+    int exp = extract64(bits, 52, 11);
+
+    if (exp == 0) {
+        return make_floatx80(high, 0);
+    }
+    return make_floatx80(high | (exp - 1023 + 0x3fff),
+                         (1ull << 63) | (extract64(bits, 0, 52) << 11));
+}
+
+static inline floatx80
+floatx80_gen2(floatx80 a, floatx80 b, float_status *s,
+              hard_fx80_op2_fn hard, hard_f64_op2_fn hard64,
+              soft_fx80_op2_fn soft, fx80_check_fn pre, fx80_check_fn post)
+{
+    if (unlikely(!can_use_fpu(s)) || unlikely(!pre(a, b))) {
+        goto soft;
+    }
+
+    switch (s->floatx80_rounding_precision) {
+    case floatx80_precision_x:
+        if (QEMU_HARDFLOAT_FX80_USE_LD) {
+            union_floatx80 ua, ub, ur;
+
+            ua.s = a;
+            ub.s = b;
+            ur.h = hard(ua.h, ub.h);
+            /* The encoding of infinity depends on floatx80_behaviour. */
+            if (unlikely(isinf(ur.h))) {
+                goto soft;
+            } else if (unlikely(fabsl(ur.h) <= LDBL_MIN) && post(a, b)) {
+                goto soft;
+            }
+            return ur.s;
+        }
+        break;
+
+    case floatx80_precision_d:
+        {
+            union_float64 ua, ub, ur;
+
+            if (!fx80_to_f64_exact(a, &ua) || !fx80_to_f64_exact(b, &ub)) {
+                goto soft;
+            }
+            ur.h = hard64(ua.h, ub.h);
+            /* Overflow of the double is not overflow of the floatx80. */
+            if (unlikely(f64_is_inf(ur))) {
+                goto soft;
+            } else if (unlikely(fabs(ur.h) <= DBL_MIN) && post(a, b)) {
+                goto soft;
+            }
+            return f64_to_fx80(ur);
+        }
+
+    default:
+        break;
+    }
+
+ soft:
+    return soft(a, b, s);
+}
+
 /*
  * Classify a floating point number. Everything above float_class_qnan
  * is a NaN so cls >= float_class_qnan is any NaN.
@@ -2187,8 +2315,8 @@ float128 float128_sub(float128 a, float128 b, float_status *status)
     return float128_addsub(a, b, status, true);
 }
 
-static floatx80 QEMU_FLATTEN
-floatx80_addsub(floatx80 a, floatx80 b, float_status *status, bool subtract)
+static floatx80 QEMU_SOFTFLOAT_ATTR
+soft_fx80_addsub(floatx80 a, floatx80 b, float_status *status, bool subtract)
 {
     FloatParts128 pa, pb, *pr;
 
@@ -2201,14 +2329,43 @@ floatx80_addsub(floatx80 a, floatx80 b, float_status *status, bool subtract)
     return floatx80_round_pack_canonical(pr, status);
 }
 
-floatx80 floatx80_add(floatx80 a, floatx80 b, float_status *status)
+static floatx80 soft_fx80_add(floatx80 a, floatx80 b, float_status *status)
+{
+    return soft_fx80_addsub(a, b, status, false);
+}
+
+static floatx80 soft_fx80_sub(floatx80 a, floatx80 b, float_status *status)
+{
+    return soft_fx80_addsub(a, b, status, true);
+}
+
+static long double hard_fx80_add(long double a, long double b)
+{
+    return a + b;
+}
+
+static long double hard_fx80_sub(long double a, long double b)
+{
+    return a - b;
+}
+
+static bool fx80_addsubmul_post(floatx80 a, floatx80 b)
 {
-    return floatx80_addsub(a, b, status, false);
+    return !(floatx80_is_zero(a) && floatx80_is_zero(b));
 }
 
-floatx80 floatx80_sub(floatx80 a, floatx80 b, float_status *status)
+floatx80 QEMU_FLATTEN
+floatx80_add(floatx80 a, floatx80 b, float_status *s)
 {
-    return floatx80_addsub(a, b, status, true);
+    return floatx80_gen2(a, b, s, hard_fx80_add, hard_f64_add, soft_fx80_add,
+                         fx80_is_zon2, fx80_addsubmul_post);
+}
+
+floatx80 QEMU_FLATTEN
+floatx80_sub(floatx80 a, floatx80 b, float_status *s)
+{
+    return floatx80_gen2(a, b, s, hard_fx80_sub, hard_f64_sub, soft_fx80_sub,
+                         fx80_is_zon2, fx80_addsubmul_post);
 }
 
 /*
@@ -2309,8 +2466,8 @@ float128_mul(float128 a, float128 b, float_status *status)
     return float128_round_pack_canonical(pr, status);
 }
 
-floatx80 QEMU_FLATTEN
-floatx80_mul(floatx80 a, floatx80 b, float_status *status)
+static floatx80 QEMU_SOFTFLOAT_ATTR
+soft_fx80_mul(floatx80 a, floatx80 b, float_status *status)
 {
     FloatParts128 pa, pb, *pr;
 
@@ -2323,6 +2480,18 @@ floatx80_mul(floatx80 a, floatx80 b, float_status *status)
     return floatx80_round_pack_canonical(pr, status);
 }
 
+static long double hard_fx80_mul(long double a, long double b)
+{
+    return a * b;
+}
+
+floatx80 QEMU_FLATTEN
+floatx80_mul(floatx80 a, floatx80 b, float_status *s)
+{
+    return floatx80_gen2(a, b, s, hard_fx80_mul, hard_f64_mul, soft_fx80_mul,
+                         fx80_is_zon2, fx80_addsubmul_post);
+}
+
 /*
  * Fused multiply-add
  */
@@ -2717,7 +2886,8 @@ float128_div(float128 a, float128 b, float_status *status)
     return float128_round_pack_canonical(pr, status);
 }
 
-floatx80 floatx80_div(floatx80 a, floatx80 b, float_status *status)
+static floatx80 QEMU_SOFTFLOAT_ATTR
+soft_fx80_div(floatx80 a, floatx80 b, float_status *status)
 {
     FloatParts128 pa, pb, *pr;
 
@@ -2730,6 +2900,29 @@ floatx80 floatx80_div(floatx80 a, floatx80 b, float_status *status)
     return floatx80_round_pack_canonical(pr, status);
 }
 
+static long double hard_fx80_div(long double a, long double b)
+{
+    return a / b;
+}
+
+static bool fx80_div_pre(floatx80 a, floatx80 b)
+{
+    return fx80_is_zero_or_normal(a) &&
+           fx80_is_zero_or_normal(b) && !floatx80_is_zero(b);
+}
+
+static bool fx80_div_post(floatx80 a, floatx80 b)
+{
+    return !floatx80_is_zero(a);
+}
+
+floatx80 QEMU_FLATTEN
+floatx80_div(floatx80 a, floatx80 b, float_status *s)
+{
+    return floatx80_gen2(a, b, s, hard_fx80_div, hard_f64_div, soft_fx80_div,
+                         fx80_div_pre, fx80_div_post);
+}
+
 /*
  * Remainder
  */
@@ -4968,7 +5161,8 @@ float128 QEMU_FLATTEN float128_sqrt(float128 a, float_status *status)
     return float128_round_pack_canonical(&p, status);
 }
 
-floatx80 floatx80_sqrt(floatx80 a, float_status *s)
+static floatx80 QEMU_SOFTFLOAT_ATTR
+soft_fx80_sqrt(floatx80 a, float_status *s)
 {
     FloatParts128 p;
 
@@ -4979,6 +5173,45 @@ floatx80 floatx80_sqrt(floatx80 a, float_status *s)
     return floatx80_round_pack_canonical(&p, s);
 }
 
+floatx80 QEMU_FLATTEN floatx80_sqrt(floatx80 a, float_status *s)
+{
+    if (unlikely(!can_use_fpu(s))) {
+        goto soft;
+    }
+    if (unlikely(!fx80_is_zero_or_normal(a) || floatx80_is_neg(a))) {
+        goto soft;
+    }
+
+    switch (s->floatx80_rounding_precision) {
+    case floatx80_precision_x:
+        if (QEMU_HARDFLOAT_FX80_USE_LD) {
+            union_floatx80 ua, ur;
+
+            ua.s = a;
+            ur.h = sqrtl(ua.h);
+            return ur.s;
+        }
+        break;
+
+    case floatx80_precision_d:
+        {
+            union_float64 ua, ur;
+
+            if (!fx80_to_f64_exact(a, &ua)) {
+                goto soft;
+            }
+            ur.h = sqrt(ua.h);
+            return f64_to_fx80(ur);
+        }
+
+    default:
+        break;
+    }
+
+ soft:
+    return soft_fx80_sqrt(a, s);
+}
+
 /*
  * log2
  */
@@ -256,6 +256,38 @@ SRST
     Show dynamic compiler info.
 ERST
 
+#if defined(CONFIG_TCG)
+    {
+        .name       = "tb-profile",
+        .args_type  = "",
+        .params     = "",
+        .help       = "show the most costly translation blocks "
+                      "(needs -accel tcg,tb-profile=on)",
+    },
+#endif
+
+SRST
+  ``info tb-profile``
+    Show the translation blocks with the highest estimated cost, with
+    their execution, translation and code generation statistics.  This
+    requires the ``tb-profile`` property of the TCG accelerator.
+ERST
+
+#if defined(CONFIG_TCG)
+    {
+        .name       = "tcg-profile",
+        .args_type  = "",
+        .params     = "",
+        .help       = "show guest code samples taken by x-tcg-profile-start",
+    },
+#endif
+
+SRST
+  ``info tcg-profile``
+    Show the guest code samples taken since the profiler was last started,
+    one translation block per line in flamegraph "folded" format.
+ERST
+
     {
         .name       = "sync-profile",
         .args_type  = "mean:-m,no_coalesce:-n,max:i?",
@@ -1078,6 +1078,36 @@ static void *rom_set_mr(Rom *rom, Object *owner, const char *name, bool ro)
     return data;
 }
 
+bool rom_init_shared(MemoryRegion *mr, Object *owner, const char *name,
+                     const char *path, uint64_t size, Error **errp)
+{
+#if defined(CONFIG_POSIX) && !defined(EMSCRIPTEN)
+    DeviceState *dev = (DeviceState *)object_dynamic_cast(owner, TYPE_DEVICE);
+
+    if (!current_machine || !current_machine->share_rom ||
+        runstate_check(RUN_STATE_INMIGRATE) || cpr_is_incoming() ||
+        size != REAL_HOST_PAGE_ALIGN(size) ||
+        get_image_size(path, NULL) != size) {
+        return false;
+    }
+
+    /*
+     * A private mapping of the image file: all processes that map the
+     * same image share its page cache pages, and a page only becomes
+     * private to us if it is written, e.g. by incoming migration.
+     */
+    if (!memory_region_init_ram_from_file(mr, owner, name, size, 0,
+                                          RAM_READONLY_FD, path, 0, errp)) {
+        return false;
+    }
+    memory_region_set_readonly(mr, true);
+    vmstate_register_ram(mr, dev);
+    return true;
+#else
+    return false;
+#endif
+}
+
 ssize_t rom_add_file(const char *file, const char *fw_dir,
                      hwaddr addr, int32_t bootindex,
                      bool has_option_rom, MemoryRegion *mr,
@@ -211,6 +211,8 @@ static int query_memdev(Object *obj, void *opaque)
         m->merge = object_property_get_bool(obj, "merge", &error_abort);
         m->dump = object_property_get_bool(obj, "dump", &error_abort);
         m->prealloc = object_property_get_bool(obj, "prealloc", &error_abort);
+        m->has_prealloc_done = host_memory_backend_get_prealloc_progress(
+            MEMORY_BACKEND(obj), &m->prealloc_done);
         m->share = object_property_get_bool(obj, "share", &error_abort);
         m->reserve = object_property_get_bool(obj, "reserve", &err);
         if (err) {
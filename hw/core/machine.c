@@ -407,6 +407,20 @@ static void machine_set_aux_ram_share(Object *obj, bool value, Error **errp)
 
     ms->aux_ram_share = value;
 }
+
+static bool machine_get_share_rom(Object *obj, Error **errp)
+{
+    MachineState *ms = MACHINE(obj);
+
+    return ms->share_rom;
+}
+
+static void machine_set_share_rom(Object *obj, bool value, Error **errp)
+{
+    MachineState *ms = MACHINE(obj);
+
+    ms->share_rom = value;
+}
 #endif
 
 static bool machine_get_usb(Object *obj, Error **errp)
@@ -1141,6 +1155,11 @@ static void machine_class_init(ObjectClass *oc, const void *data)
                                    machine_set_aux_ram_share);
     object_class_property_set_description(oc, "aux-ram-share",
         "Use anonymous shared memory for auxiliary guest RAMs");
+    object_class_property_add_bool(oc, "share-rom",
+                                   machine_get_share_rom,
+                                   machine_set_share_rom);
+    object_class_property_set_description(oc, "share-rom",
+        "Map firmware and option ROM images instead of copying them");
 #endif
 
     object_class_property_add_bool(oc, "usb",
@@ -1053,6 +1053,10 @@ static void load_bios_from_file(X86MachineState *x86ms, const char *bios_name,
         if (is_tdx_vm()) {
             tdx_set_tdvf_region(&x86ms->bios);
         }
+    } else if (!isapc_ram_fw && !sev_enabled() && !is_tdx_vm() &&
+               rom_init_shared(&x86ms->bios, NULL, "pc.bios", filename,
+                               bios_size, &error_fatal)) {
+        return;
     } else {
         memory_region_init_ram(&x86ms->bios, NULL, "pc.bios",
                                bios_size, &error_fatal);
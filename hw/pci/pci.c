@@ -2532,10 +2532,12 @@ static void pci_patch_ids(PCIDevice *pdev, uint8_t *ptr, uint32_t size)
 static void pci_add_option_rom(PCIDevice *pdev, bool is_default_rom,
                                Error **errp)
 {
+    ERRP_GUARD();
     int64_t size = 0;
     g_autofree char *path = NULL;
     char name[32];
     const VMStateDescription *vmsd;
+    bool shared;
 
     /*
      * In case of incoming migration ROM will come with migration stream, no
@@ -2617,13 +2619,20 @@ static void pci_add_option_rom(PCIDevice *pdev, bool is_default_rom,
              vmsd ? vmsd->name : object_get_typename(OBJECT(pdev)));
 
     pdev->has_rom = true;
-    memory_region_init_rom(&pdev->rom, OBJECT(pdev), name, pdev->romsize,
-                           &error_fatal);
+    shared = load_file && rom_init_shared(&pdev->rom, OBJECT(pdev), name,
+                                          path, pdev->romsize, errp);
+    if (*errp) {
+        return;
+    }
+    if (!shared) {
+        memory_region_init_rom(&pdev->rom, OBJECT(pdev), name, pdev->romsize,
+                               &error_fatal);
+    }
 
     if (load_file) {
         void *ptr = memory_region_get_ram_ptr(&pdev->rom);
 
-        if (load_image_size(path, ptr, size) < 0) {
+        if (!shared && load_image_size(path, ptr, size) < 0) {
             error_setg(errp, "failed to load romfile \"%s\"", pdev->romfile);
             return;
         }
@@ -84,6 +84,25 @@ void tlb_set_page_with_attrs(CPUState *cpu, vaddr addr,
                              hwaddr paddr, MemTxAttrs attrs,
                              int prot, int mmu_idx, vaddr size);
 
+/**
+ * tlb_set_direct_window:
+ * @cpu: CPU context
+ * @host: host address backing virtual address 0
+ * @len: size of the window in bytes, rounded down to whole pages
+ *
+ * Declare that, in every mmu_idx, virtual addresses [0, @len) are
+ * identity mapped onto guest RAM whose host copy starts at @host, so
+ * that translated code may load from them without consulting the TLB.
+ * The window is emptied by the next tlb flush that covers any part of
+ * it, and is never set while the cpu has watchpoints.  Stores, and
+ * anything else that needs dirty tracking, must still use the TLB.
+ *
+ * This must be called from the cpu's own thread, normally from its
+ * tlb_fill function.  The target is responsible for emitting the
+ * range check against cpu->neg.tlb.direct in translated code.
+ */
+void tlb_set_direct_window(CPUState *cpu, void *host, vaddr len);
+
 /**
  * tlb_set_page:
  *
@@ -96,6 +96,9 @@ struct TranslationBlock {
 
     struct tb_tc tc;
 
+    /* Statistics kept with -accel tcg,tb-profile=on, or NULL */
+    struct TBProfile *profile;
+
     /*
      * Track tb_page_addr_t intervals that intersect this TB.
      * For user-only, the virtual addresses are always contiguous,
@@ -415,6 +415,7 @@ struct MachineState {
     ConfidentialGuestSupport *cgs;
     HostMemoryBackend *memdev;
     bool aux_ram_share;
+    bool share_rom;
     /*
      * convenience alias to ram_memdev_id backend memory region
      * or to numa container memory region
@@ -212,6 +212,9 @@ typedef uint32_t MMUIdxMap;
 /* Use a fully associative victim tlb of 8 entries. */
 #define CPU_VTLB_SIZE 8
 
+/* Use a fully associative large page tlb of 8 entries. */
+#define CPU_LTLB_SIZE 8
+
 /*
  * The full TLB entry, which is not accessed by generated TCG code,
  * so the layout is not as critical as that of CPUTLBEntry. This is
@@ -276,23 +279,43 @@ struct CPUTLBEntryFull {
     } extra;
 };
 
+/*
+ * A translation for a page larger than TARGET_PAGE_SIZE, as provided
+ * by tlb_fill.  A virtual address @va is within the page if
+ * (@va & @mask) == @addr, and @full.phys_addr is the physical address
+ * of the start of the page.
+ * An unused entry has addr == mask == -1.
+ */
+typedef struct CPUTLBLargeEntry {
+    vaddr addr;
+    vaddr mask;
+    CPUTLBEntryFull full;
+} CPUTLBLargeEntry;
+
 /*
  * Data elements that are per MMU mode, minus the bits accessed by
  * the TCG fast path.
  */
 typedef struct CPUTLBDesc {
     /*
-     * Describe a region covering all of the large pages allocated
-     * into the tlb.  When any page within this region is flushed,
-     * we must flush the entire tlb.  The region is matched if
+     * Describe a region covering all of the large pages that were
+     * evicted from the large page tlb while still in use by the tlb.
+     * When any page within this region is flushed, we must flush the
+     * entire tlb.  The region is matched if
      * (addr & large_page_mask) == large_page_addr.
      */
     vaddr large_page_addr;
     vaddr large_page_mask;
+    /* The next index to use in the large page tlb.  */
+    size_t lindex;
+    /* The large pages whose TARGET_PAGE_SIZE pieces may be in the tlb.  */
+    CPUTLBLargeEntry ltable[CPU_LTLB_SIZE];
     /* host time (in ns) at the beginning of the time window */
     int64_t window_begin_ns;
     /* maximum number of entries observed in the window */
     size_t window_max_entries;
+    /* number of valid entries evicted by a conflicting page in the window */
+    size_t window_evictions;
     size_t n_used_entries;
     /* The next index to use in the tlb victim table.  */
     size_t vindex;
@@ -322,8 +345,24 @@ typedef struct CPUTLBCommon {
     size_t full_flush_count;
     size_t part_flush_count;
     size_t elide_flush_count;
+    /* Misses of the main tlb, by how they were resolved.  */
+    size_t victim_hit_count;
+    size_t large_hit_count;
+    size_t fill_count;
+    /* Valid entries evicted from the main tlb by a conflicting page.  */
+    size_t evict_count;
 } CPUTLBCommon;
 
+/*
+ * A window of guest virtual addresses, starting at 0, which the target
+ * has declared to be backed by host memory at @host for loads.  It is
+ * read by translated code and emptied by every tlb flush.
+ */
+typedef struct CPUTLBDirect {
+    uintptr_t host;
+    vaddr limit;
+} CPUTLBDirect;
+
 /*
  * The entire softmmu tlb, for all MMU modes.
  * The meaning of each of the MMU modes is defined in the target code.
@@ -334,6 +373,7 @@ typedef struct CPUTLB {
 #ifdef CONFIG_TCG
     CPUTLBCommon c;
     CPUTLBDesc d[NB_MMU_MODES];
+    CPUTLBDirect direct;
     CPUTLBDescFast f[NB_MMU_MODES];
 #endif
 } CPUTLB;
@@ -438,6 +478,8 @@ struct qemu_work_item;
  *   the one provided by cpu_exit(), especially when processing interrupt
  *   flags.  In this case, the write and read happen in the same thread
  *   and the write therefore can use qemu_atomic_set().
+ * @profile_sample: The TCG profiler asks for the guest PC at the next
+ *   translation block boundary.  Only used by system emulation.
  * @interrupt_request: Indicates a pending interrupt request.
  *   Only used by system emulation.
  * @halted: Nonzero if the CPU is in suspended state.
@@ -508,6 +550,7 @@ struct CPUState {
     bool unplug;
     bool crash_occurred;
     bool exit_request;
+    bool profile_sample;
     int exclusive_context_count;
     uint32_t cflags_next_tb;
     uint32_t interrupt_request;
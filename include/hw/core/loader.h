@@ -259,6 +259,26 @@ void pstrcpy_targphys(const char *name,
                       hwaddr dest, int buf_size,
                       const char *source);
 
+/**
+ * rom_init_shared: map a ROM image instead of loading a copy of it
+ * @mr: the memory region to initialize
+ * @owner: the object that tracks the region's reference count
+ * @name: name of the region, as for memory_region_init_rom()
+ * @path: the image file
+ * @size: size of the region, which the image must fill exactly
+ * @errp: returns an error if this function fails
+ *
+ * With -machine share-rom=on, initialize @mr as a read-only region that
+ * maps the image copy-on-write, so that all guests using the same image
+ * share one copy of it in the host page cache.  As the image is not
+ * registered with rom_add_file(), it is not reloaded on reset.
+ *
+ * Return: true if @mr was initialized.  Otherwise @mr is left alone and
+ * the caller must load the image itself; @errp is set if the image
+ * could not be mapped.
+ */
+bool rom_init_shared(MemoryRegion *mr, Object *owner, const char *name,
+                     const char *path, uint64_t size, Error **errp);
 ssize_t rom_add_file(const char *file, const char *fw_dir,
                      hwaddr addr, int32_t bootindex,
                      bool has_option_rom, MemoryRegion *mr, AddressSpace *as);
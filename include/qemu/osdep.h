@@ -757,6 +757,48 @@ bool qemu_prealloc_mem(int fd, char *area, size_t sz, int max_threads,
  */
 bool qemu_finish_async_prealloc_mem(Error **errp);
 
+typedef struct MemPreallocJob MemPreallocJob;
+
+/**
+ * qemu_prealloc_mem_background:
+ * @fd: the fd mapped into the area, -1 for anonymous memory
+ * @area: start address of the are to preallocate
+ * @sz: the size of the area to preallocate
+ * @max_threads: maximum number of threads to use
+ * @tc: prealloc context threads pointer, NULL if not in use
+ * @jobp: returns the background job, or NULL if there is none
+ * @errp: returns an error if this function fails
+ *
+ * Like qemu_prealloc_mem(), but return as soon as the preallocation
+ * threads are started, so that the area can be used while it is being
+ * populated.  If that cannot be done safely, for example because
+ * MADV_POPULATE_WRITE is not supported, preallocate synchronously and
+ * set *@jobp to NULL.  Failures of the background job are only reported
+ * as warnings, the remaining pages are then faulted in on demand.
+ *
+ * Return: true on success, else false setting @errp with error.
+ */
+bool qemu_prealloc_mem_background(int fd, char *area, size_t sz,
+                                  int max_threads, ThreadContext *tc,
+                                  MemPreallocJob **jobp, Error **errp);
+
+/**
+ * qemu_prealloc_job_done:
+ * @job: a job returned by qemu_prealloc_mem_background()
+ *
+ * Return: the number of bytes populated by @job so far.
+ */
+size_t qemu_prealloc_job_done(MemPreallocJob *job);
+
+/**
+ * qemu_prealloc_job_free:
+ * @job: a job returned by qemu_prealloc_mem_background(), or NULL
+ *
+ * Stop @job if it is still running, wait for its threads and free it.
+ * The memory area must stay mapped until this returns.
+ */
+void qemu_prealloc_job_free(MemPreallocJob *job);
+
 /**
  * qemu_get_pid_name:
  * @pid: pid of a process
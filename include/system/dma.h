@@ -84,8 +84,8 @@ static inline MemTxResult dma_memory_rw_relaxed(AddressSpace *as,
                                                 DMADirection dir,
                                                 MemTxAttrs attrs)
 {
-    return address_space_rw(as, addr, attrs,
-                            buf, len, dir == DMA_DIRECTION_FROM_DEVICE);
+    return address_space_dma_rw(as, addr, attrs,
+                                buf, len, dir == DMA_DIRECTION_FROM_DEVICE);
 }
 
 static inline MemTxResult dma_memory_read_relaxed(AddressSpace *as,
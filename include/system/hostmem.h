@@ -67,6 +67,7 @@ struct HostMemoryBackendClass {
  * @size: amount of memory backend provides
  * @mr: MemoryRegion representing host memory belonging to backend
  * @prealloc_threads: number of threads to be used for preallocatining RAM
+ * @prealloc_job: background preallocation in progress, if any
  */
 struct HostMemoryBackend {
     /* private */
@@ -76,9 +77,10 @@ struct HostMemoryBackend {
     uint64_t size;
     bool merge, dump, use_canonical_path;
     bool prealloc, is_mapped, share, reserve;
-    bool guest_memfd, aligned;
+    bool guest_memfd, aligned, prealloc_background;
     uint32_t prealloc_threads;
     ThreadContext *prealloc_context;
+    MemPreallocJob *prealloc_job;
     DECLARE_BITMAP(host_nodes, MAX_NODES + 1);
     HostMemPolicy policy;
 
@@ -93,6 +95,13 @@ bool host_memory_backend_is_mapped(HostMemoryBackend *backend);
 size_t host_memory_backend_pagesize(HostMemoryBackend *memdev);
 char *host_memory_backend_get_name(HostMemoryBackend *backend);
 
+/*
+ * Return true and store the number of bytes preallocated so far to *@done
+ * if @backend preallocates its memory in the background.
+ */
+bool host_memory_backend_get_prealloc_progress(HostMemoryBackend *backend,
+                                               uint64_t *done);
+
 long qemu_minrampagesize(void);
 long qemu_maxrampagesize(void);
 
@@ -48,6 +48,19 @@ uint8_t cpu_inb(uint32_t addr);
 uint16_t cpu_inw(uint32_t addr);
 uint32_t cpu_inl(uint32_t addr);
 
+/*
+ * Fast paths for accesses to address_space_io, through a table that
+ * maps each port to the region behind it.  Perform a @op access at
+ * @port and return true, or return false if the access needs to go
+ * through the address space, e.g. because it crosses a region boundary
+ * or would have to be split.
+ */
+bool ioport_dispatch_read(uint32_t port, MemOp op, uint64_t *pval,
+                          MemTxAttrs attrs);
+bool ioport_dispatch_write(uint32_t port, MemOp op, uint64_t val,
+                           MemTxAttrs attrs);
+void ioport_dispatch_init(void);
+
 typedef struct PortioList {
     const struct MemoryRegionPortio *ports;
     Object *owner;
@@ -1183,6 +1183,11 @@ struct AddressSpace {
     /* List of callbacks to invoke when buffers free up */
     QemuMutex map_client_list_lock;
     QLIST_HEAD(, AddressSpaceMapClient) map_client_list;
+
+    /* Last RAM section used by address_space_dma_rw(), accessed via RCU. */
+    struct AddressSpaceDMACache *dma_cache;
+    /* Incremented whenever current_map changes, invalidating dma_cache. */
+    unsigned dma_cache_gen;
 };
 
 typedef struct AddressSpaceDispatch AddressSpaceDispatch;
@@ -2702,6 +2707,27 @@ MemTxResult address_space_rw(AddressSpace *as, hwaddr addr,
                              MemTxAttrs attrs, void *buf,
                              hwaddr len, bool is_write);
 
+/**
+ * address_space_dma_rw: read from or write to an address space on behalf
+ * of a DMA-capable device.
+ *
+ * Like address_space_rw(), but remembers the last RAM section that was
+ * accessed in @as, so that a device that repeatedly accesses the same
+ * area of guest memory (e.g. a descriptor ring) skips the address space
+ * lookup.  The cache is dropped whenever the topology of @as changes;
+ * accesses through an IOMMU are never cached.
+ *
+ * @as: #AddressSpace to be accessed
+ * @addr: address within that address space
+ * @attrs: memory transaction attributes
+ * @buf: buffer with the data transferred
+ * @len: the number of bytes to read or write
+ * @is_write: indicates the transfer direction
+ */
+MemTxResult address_space_dma_rw(AddressSpace *as, hwaddr addr,
+                                 MemTxAttrs attrs, void *buf,
+                                 hwaddr len, bool is_write);
+
 /**
  * address_space_write: write to address space.
  *
@@ -3005,6 +3031,12 @@ MemTxResult address_space_set(AddressSpace *as, hwaddr addr,
  */
 void qemu_flush_coalesced_mmio_buffer(void);
 
+/*
+ * Perform the coalesced writes that were queued while running with TCG.
+ * Must be called with the BQL held if any are pending.
+ */
+void memory_region_flush_coalesced_tcg(void);
+
 /*
  * Inhibit technologies that require discarding of pages in RAM blocks, e.g.,
  * to manage the actual amount of memory consumed by the VM (then, the memory
@@ -1,6 +1,7 @@
 #ifndef RAMLIST_H
 #define RAMLIST_H
 
+#include "qemu/bitops.h"
 #include "qemu/queue.h"
 #include "qemu/thread.h"
 #include "qemu/rcu.h"
@@ -35,11 +36,42 @@ typedef struct RAMBlockNotifier RAMBlockNotifier;
  * pointed to from the new DirtyMemoryBlocks).
  */
 #define DIRTY_MEMORY_BLOCK_SIZE ((ram_addr_t)256 * 1024 * 8)
+#define DIRTY_MEMORY_BLOCK_WORDS BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE)
 typedef struct {
     struct rcu_head rcu;
     unsigned long *blocks[];
 } DirtyMemoryBlocks;
 
+/*
+ * Each block is followed by a summary bitmap with one bit per word of
+ * the block.  Whoever sets bits in a word sets its summary bit after
+ * it, so a word whose summary bit is clear has no dirty pages.  This
+ * lets consumers that harvest dirty bits skip clean memory 64 pages at
+ * a time, and find dirty words with find_next_bit() on the summary.
+ */
+static inline unsigned long *dirty_memory_block_summary(unsigned long *block)
+{
+    return block + DIRTY_MEMORY_BLOCK_WORDS;
+}
+
+/*
+ * Atomically fetch and clear word @word of @block.  The summary bit is
+ * cleared first, so that concurrent writers set it again if they dirty
+ * the word after it was fetched.
+ */
+static inline unsigned long dirty_memory_block_harvest(unsigned long *block,
+                                                       unsigned long word)
+{
+    unsigned long *summary = &dirty_memory_block_summary(block)[BIT_WORD(word)];
+    unsigned long mask = BIT_MASK(word);
+
+    if (!(qatomic_read(summary) & mask) ||
+        !(qatomic_fetch_and(summary, ~mask) & mask)) {
+        return 0;
+    }
+    return qatomic_xchg(&block[word], 0);
+}
+
 typedef struct RAMList {
     QemuMutex mutex;
     RAMBlock *mru_block;
@@ -0,0 +1,31 @@
+/*
+ * Guest symbol tables supplied by the user.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#ifndef TCG_GUEST_SYMBOLS_H
+#define TCG_GUEST_SYMBOLS_H
+
+/*
+ * Load the symbols in @path, replacing any that were loaded before.
+ * The file is either a PE image, whose named exports are used, or the
+ * text output of nm(1); System.map and /proc/kallsyms also qualify.
+ * The PE image is assumed to be loaded at @base, or at its preferred
+ * base address if @base is 0.
+ */
+bool guest_symbols_load(const char *path, uint64_t base, Error **errp);
+
+/*
+ * Forget all loaded symbols.
+ */
+void guest_symbols_clear(void);
+
+/*
+ * Return the closest symbol at or below @addr and store the distance
+ * from it to *@offset, or return NULL.  Must be called within an RCU
+ * read-side critical section, which bounds the lifetime of the name.
+ */
+const char *guest_symbols_lookup(uint64_t addr, uint64_t *offset);
+
+#endif
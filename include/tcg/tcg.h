@@ -351,6 +351,7 @@ struct TCGContext {
     int nb_temps;
     int nb_indirects;
     int nb_ops;
+    int nb_ops_before_opt;        /* for -accel tcg,tb-profile=on */
     TCGType addr_type;            /* TCG_TYPE_I32 or TCG_TYPE_I64 */
     TCGBar guest_mo;
 
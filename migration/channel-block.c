@@ -22,8 +22,19 @@
 #include "migration/channel-block.h"
 #include "qapi/error.h"
 #include "block/block.h"
+#include "block/graph-lock.h"
+#include "qemu/coroutine.h"
+#include "qemu/iov.h"
+#include "qemu/units.h"
 #include "trace.h"
 
+/*
+ * Loading a snapshot reads the VMState region sequentially through the
+ * QEMUFile buffer, which asks for a few KiB at a time.  Read larger
+ * chunks instead, and overlap reading the next one with parsing.
+ */
+#define QIO_CHANNEL_BLOCK_READAHEAD (1 * MiB)
+
 QIOChannelBlock *
 qio_channel_block_new(BlockDriverState *bs)
 {
@@ -39,15 +50,99 @@ qio_channel_block_new(BlockDriverState *bs)
 }
 
 
+static void
+qio_channel_block_readahead_drop(QIOChannelBlock *bioc)
+{
+    int i;
+
+    if (qatomic_load_acquire(&bioc->ra_pending)) {
+        BDRV_POLL_WHILE(bioc->bs, qatomic_load_acquire(&bioc->ra_pending));
+    }
+    for (i = 0; i < ARRAY_SIZE(bioc->ra); i++) {
+        g_clear_pointer(&bioc->ra[i].data, qemu_vfree);
+        bioc->ra[i].len = 0;
+    }
+}
+
+
 static void
 qio_channel_block_finalize(Object *obj)
 {
     QIOChannelBlock *ioc = QIO_CHANNEL_BLOCK(obj);
 
+    if (ioc->bs) {
+        qio_channel_block_readahead_drop(ioc);
+    }
     g_clear_pointer(&ioc->bs, bdrv_unref);
 }
 
 
+static void coroutine_fn
+qio_channel_block_prefetch_co(void *opaque)
+{
+    QIOChannelBlock *bioc = opaque;
+    QIOChannelBlockBuffer *next = &bioc->ra[1];
+    QEMUIOVector qiov;
+    int ret;
+
+    qemu_iovec_init_buf(&qiov, next->data, QIO_CHANNEL_BLOCK_READAHEAD);
+    WITH_GRAPH_RDLOCK_GUARD() {
+        ret = bdrv_readv_vmstate(bioc->bs, &qiov, next->offset);
+    }
+
+    /* On error, the next read retries synchronously and reports it. */
+    next->len = ret < 0 ? 0 : QIO_CHANNEL_BLOCK_READAHEAD;
+    qatomic_store_release(&bioc->ra_pending, false);
+    aio_wait_kick();
+}
+
+
+/*
+ * Make @ra[0] contain the current offset, and start prefetching the
+ * chunk after it.
+ */
+static int
+qio_channel_block_readahead(QIOChannelBlock *bioc)
+{
+    QIOChannelBlockBuffer *cur = &bioc->ra[0], *next = &bioc->ra[1];
+    QEMUIOVector qiov;
+    Coroutine *co;
+    int ret;
+
+    if (!cur->data) {
+        cur->data = qemu_blockalign(bioc->bs, QIO_CHANNEL_BLOCK_READAHEAD);
+        next->data = qemu_blockalign(bioc->bs, QIO_CHANNEL_BLOCK_READAHEAD);
+    }
+
+    if (qatomic_load_acquire(&bioc->ra_pending)) {
+        BDRV_POLL_WHILE(bioc->bs, qatomic_load_acquire(&bioc->ra_pending));
+    }
+    if (bioc->offset >= next->offset &&
+        bioc->offset < next->offset + next->len) {
+        QIOChannelBlockBuffer tmp = *cur;
+
+        *cur = *next;
+        *next = tmp;
+    } else {
+        cur->offset = bioc->offset;
+        cur->len = 0;
+        qemu_iovec_init_buf(&qiov, cur->data, QIO_CHANNEL_BLOCK_READAHEAD);
+        ret = bdrv_readv_vmstate(bioc->bs, &qiov, cur->offset);
+        if (ret < 0) {
+            return ret;
+        }
+        cur->len = QIO_CHANNEL_BLOCK_READAHEAD;
+    }
+
+    next->offset = cur->offset + cur->len;
+    next->len = 0;
+    qatomic_set(&bioc->ra_pending, true);
+    co = qemu_coroutine_create(qio_channel_block_prefetch_co, bioc);
+    aio_co_enter(bdrv_get_aio_context(bioc->bs), co);
+    return 0;
+}
+
+
 static ssize_t
 qio_channel_block_readv(QIOChannel *ioc,
                         const struct iovec *iov,
@@ -58,18 +153,45 @@ qio_channel_block_readv(QIOChannel *ioc,
                         Error **errp)
 {
     QIOChannelBlock *bioc = QIO_CHANNEL_BLOCK(ioc);
+    QIOChannelBlockBuffer *cur = &bioc->ra[0];
     QEMUIOVector qiov;
+    size_t size, done = 0;
     int ret;
 
-    qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
-    ret = bdrv_readv_vmstate(bioc->bs, &qiov, bioc->offset);
-    if (ret < 0) {
-        error_setg_errno(errp, -ret, "bdrv_readv_vmstate failed");
-        return -1;
+    /* Waiting for the prefetch needs a polling loop, not a coroutine. */
+    if (qemu_in_coroutine()) {
+        qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
+        ret = bdrv_readv_vmstate(bioc->bs, &qiov, bioc->offset);
+        if (ret < 0) {
+            error_setg_errno(errp, -ret, "bdrv_readv_vmstate failed");
+            return -1;
+        }
+
+        bioc->offset += qiov.size;
+        return qiov.size;
     }
 
-    bioc->offset += qiov.size;
-    return qiov.size;
+    size = iov_size(iov, niov);
+    while (done < size) {
+        size_t len;
+
+        if (bioc->offset < cur->offset ||
+            bioc->offset >= cur->offset + cur->len) {
+            ret = qio_channel_block_readahead(bioc);
+            if (ret < 0) {
+                error_setg_errno(errp, -ret, "bdrv_readv_vmstate failed");
+                return -1;
+            }
+        }
+
+        len = MIN(size - done, cur->offset + cur->len - bioc->offset);
+        iov_from_buf(iov, niov, done, cur->data + (bioc->offset - cur->offset),
+                     len);
+        bioc->offset += len;
+        done += len;
+    }
+
+    return done;
 }
 
 
@@ -86,6 +208,7 @@ qio_channel_block_writev(QIOChannel *ioc,
     QEMUIOVector qiov;
     int ret;
 
+    qio_channel_block_readahead_drop(bioc);
     qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
     ret = bdrv_writev_vmstate(bioc->bs, &qiov, bioc->offset);
     if (ret < 0) {
@@ -129,6 +252,7 @@ qio_channel_block_pwritev(QIOChannel *ioc,
     QEMUIOVector qiov;
     int ret;
 
+    qio_channel_block_readahead_drop(bioc);
     qemu_iovec_init_external(&qiov, (struct iovec *)iov, niov);
     ret = bdrv_writev_vmstate(bioc->bs, &qiov, offset);
     if (ret < 0) {
@@ -183,7 +307,10 @@ qio_channel_block_close(QIOChannel *ioc,
                         Error **errp)
 {
     QIOChannelBlock *bioc = QIO_CHANNEL_BLOCK(ioc);
-    int rv = bdrv_flush(bioc->bs);
+    int rv;
+
+    qio_channel_block_readahead_drop(bioc);
+    rv = bdrv_flush(bioc->bs);
 
     if (rv < 0) {
         error_setg_errno(errp, -rv,
@@ -36,10 +36,27 @@ OBJECT_DECLARE_SIMPLE_TYPE(QIOChannelBlock, QIO_CHANNEL_BLOCK)
  * to the VMState region.
  */
 
+typedef struct QIOChannelBlockBuffer {
+    uint8_t *data;
+    off_t offset;
+    size_t len;
+} QIOChannelBlockBuffer;
+
 struct QIOChannelBlock {
     QIOChannel parent;
     BlockDriverState *bs;
     off_t offset;
+
+    /*
+     * Sequential reads are served from @ra[0], while @ra[1] is filled
+     * in the background with the data that follows it.
+     */
+    QIOChannelBlockBuffer ra[2];
+    /*
+     * Cleared by the prefetch coroutine, which may run in an iothread,
+     * once @ra[1] is filled.  Accessed with atomics.
+     */
+    bool ra_pending;
 };
 
 
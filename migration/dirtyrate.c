@@ -352,7 +352,7 @@ static void update_dirtyrate(uint64_t msec)
 /*
  * Compute hash of a single page of size TARGET_PAGE_SIZE.
  */
-static uint32_t compute_page_hash(void *ptr)
+uint64_t compute_page_hash64(const void *ptr)
 {
     size_t page_size = qemu_target_page_size();
     uint32_t i;
@@ -372,8 +372,12 @@ static uint32_t compute_page_hash(void *ptr)
     }
     res = XXH64_mergerounds(v1, v2, v3, v4);
     res += page_size;
-    res = XXH64_avalanche(res);
-    return (uint32_t)(res & UINT32_MAX);
+    return XXH64_avalanche(res);
+}
+
+static uint32_t compute_page_hash(void *ptr)
+{
+    return (uint32_t)(compute_page_hash64(ptr) & UINT32_MAX);
 }
 
 
@@ -84,4 +84,5 @@ struct DirtyRateStat {
 };
 
 void *get_dirtyrate_thread(void *arg);
+uint64_t compute_page_hash64(const void *ptr);
 #endif
@@ -31,6 +31,7 @@
 
 #define  MIGRATION_THREAD_SNAPSHOT          "mig/snapshot"
 #define  MIGRATION_THREAD_DIRTY_RATE        "mig/dirtyrate"
+#define  MIGRATION_THREAD_RAM_DEDUP         "mig/ramdedup"
 
 #define  MIGRATION_THREAD_SRC_MAIN          "mig/src/main"
 #define  MIGRATION_THREAD_SRC_MULTIFD       "mig/src/send_%d"
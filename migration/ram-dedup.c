@@ -0,0 +1,325 @@
+/*
+ * Guest RAM deduplication scan
+ *
+ * Hash the guest pages that KSM could merge to find out how much memory
+ * merging identical pages would save.  On request, ranges that are
+ * mostly made of zero or duplicate pages are marked mergeable, so that
+ * KSM only scans the parts of guest RAM where merging pays off.  The
+ * pages themselves are never touched: merging is left to the host,
+ * which write-protects them first, so the scan does not have to stop
+ * the guest or get in the way of dirty logging.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qemu/cutils.h"
+#include "qemu/madvise.h"
+#include "qemu/rcu.h"
+#include "qemu/units.h"
+#include "qapi/error.h"
+#include "qapi/qapi-commands-migration.h"
+#include "system/ramblock.h"
+#include "exec/target_page.h"
+#include "dirtyrate.h"
+#include "migration.h"
+#include "ram.h"
+
+/* Granularity at which residency is checked and ranges are hinted. */
+#define RAM_DEDUP_CHUNK (2 * MiB)
+
+static struct {
+    /* RamDedupStatus; results below are valid once it is "scanned" */
+    int status;
+    bool merge;
+    uint64_t scanned_pages;
+    uint64_t zero_pages;
+    uint64_t duplicate_pages;
+    uint64_t hinted;
+} ram_dedup;
+
+/*
+ * KSM only merges private anonymous memory in small pages.  Reading any
+ * other kind of memory would also populate it, e.g. fill the page cache
+ * for file-backed memory or allocate huge pages.
+ */
+static bool ram_dedup_skip_block(RAMBlock *block)
+{
+    return qemu_ram_is_shared(block) || qemu_ram_get_fd(block) >= 0 ||
+           qemu_ram_pagesize(block) != qemu_real_host_page_size();
+}
+
+/*
+ * Fill @resident with one byte per host page in the @len bytes at @host,
+ * with bit 0 set if the page is in memory.
+ */
+static void ram_dedup_get_resident(uint8_t *host, size_t len,
+                                   unsigned char *resident)
+{
+#ifdef CONFIG_LINUX
+    if (!mincore(host, len, resident)) {
+        return;
+    }
+#endif
+    memset(resident, 1, DIV_ROUND_UP(len, qemu_real_host_page_size()));
+}
+
+static bool ram_dedup_skip_page(RAMBlock *block, ram_addr_t chunk,
+                                const unsigned char *resident,
+                                ram_addr_t offset)
+{
+    size_t host_page = (offset - chunk) / qemu_real_host_page_size();
+
+    /* Reading a swapped out or discarded page would fault it back in. */
+    return !(resident[host_page] & 1) ||
+           ramblock_page_is_discarded(block, offset);
+}
+
+/* Hash the non-zero pages of @block into @hashes, return their number. */
+static size_t ram_dedup_hash_block(RAMBlock *block, uint64_t *hashes)
+{
+    size_t page_size = qemu_target_page_size();
+    ram_addr_t len = qemu_ram_get_used_length(block);
+    uint8_t *host = qemu_ram_get_host_addr(block);
+    g_autofree unsigned char *resident =
+        g_new(unsigned char, RAM_DEDUP_CHUNK / qemu_real_host_page_size());
+    size_t n = 0;
+    ram_addr_t chunk, offset;
+
+    for (chunk = 0; chunk < len; chunk += RAM_DEDUP_CHUNK) {
+        ram_addr_t end = MIN(chunk + RAM_DEDUP_CHUNK, len);
+
+        ram_dedup_get_resident(host + chunk, end - chunk, resident);
+        for (offset = chunk; offset < end; offset += page_size) {
+            if (ram_dedup_skip_page(block, chunk, resident, offset)) {
+                continue;
+            }
+            if (buffer_is_zero(host + offset, page_size)) {
+                qatomic_inc(&ram_dedup.zero_pages);
+            } else {
+                hashes[n++] = compute_page_hash64(host + offset);
+            }
+            qatomic_inc(&ram_dedup.scanned_pages);
+        }
+    }
+    return n;
+}
+
+static int ram_dedup_hash_cmp(const void *a, const void *b)
+{
+    uint64_t ha = *(const uint64_t *)a, hb = *(const uint64_t *)b;
+
+    return ha < hb ? -1 : ha > hb;
+}
+
+/* Return whether @hash appears more than once in the sorted @hashes. */
+static bool ram_dedup_is_duplicate(const uint64_t *hashes, size_t n,
+                                   uint64_t hash)
+{
+    const uint64_t *p = bsearch(&hash, hashes, n, sizeof(*hashes),
+                                ram_dedup_hash_cmp);
+    size_t i;
+
+    if (!p) {
+        return false;
+    }
+    i = p - hashes;
+    return (i > 0 && hashes[i - 1] == hash) ||
+           (i + 1 < n && hashes[i + 1] == hash);
+}
+
+/*
+ * Mark the chunks of @block where at least half of the pages are zero
+ * or duplicates as mergeable, return the number of bytes marked.
+ */
+static uint64_t ram_dedup_hint_block(RAMBlock *block, const uint64_t *hashes,
+                                     size_t n)
+{
+    size_t page_size = qemu_target_page_size();
+    ram_addr_t len = qemu_ram_get_used_length(block);
+    uint8_t *host = qemu_ram_get_host_addr(block);
+    g_autofree unsigned char *resident =
+        g_new(unsigned char, RAM_DEDUP_CHUNK / qemu_real_host_page_size());
+    ram_addr_t chunk, run_start = 0, run_len = 0;
+    uint64_t hinted = 0;
+
+    for (chunk = 0; chunk < len; chunk += RAM_DEDUP_CHUNK) {
+        ram_addr_t end = MIN(chunk + RAM_DEDUP_CHUNK, len);
+        ram_addr_t offset;
+        size_t pages = 0, mergeable = 0;
+
+        ram_dedup_get_resident(host + chunk, end - chunk, resident);
+        for (offset = chunk; offset < end; offset += page_size) {
+            if (ram_dedup_skip_page(block, chunk, resident, offset)) {
+                continue;
+            }
+            pages++;
+            if (buffer_is_zero(host + offset, page_size) ||
+                ram_dedup_is_duplicate(hashes, n,
+                                       compute_page_hash64(host + offset))) {
+                mergeable++;
+            }
+        }
+
+        if (pages && mergeable * 2 >= pages) {
+            if (!run_len) {
+                run_start = chunk;
+            }
+            run_len += end - chunk;
+            continue;
+        }
+        if (run_len && !qemu_madvise(host + run_start, run_len,
+                                     QEMU_MADV_MERGEABLE)) {
+            hinted += run_len;
+        }
+        run_len = 0;
+    }
+
+    if (run_len && !qemu_madvise(host + run_start, run_len,
+                                 QEMU_MADV_MERGEABLE)) {
+        hinted += run_len;
+    }
+    return hinted;
+}
+
+/*
+ * Return the blocks to scan, each with a reference taken, so that the
+ * RCU read lock need not be held while going through all of guest RAM.
+ * Store in @pages how many pages they may hold, even if resized.
+ */
+static GPtrArray *ram_dedup_get_blocks(size_t *pages)
+{
+    GPtrArray *blocks = g_ptr_array_new();
+    RAMBlock *block;
+
+    *pages = 0;
+    RCU_READ_LOCK_GUARD();
+    RAMBLOCK_FOREACH_MIGRATABLE(block) {
+        if (ram_dedup_skip_block(block)) {
+            continue;
+        }
+        memory_region_ref(block->mr);
+        g_ptr_array_add(blocks, block);
+        *pages += qemu_ram_get_max_length(block) / qemu_target_page_size();
+    }
+    return blocks;
+}
+
+static void *ram_dedup_thread(void *opaque)
+{
+    g_autoptr(GPtrArray) blocks = NULL;
+    uint64_t *hashes = NULL;
+    size_t total, n = 0, distinct, i;
+    int status = RAM_DEDUP_STATUS_FAILED;
+
+    rcu_register_thread();
+
+    blocks = ram_dedup_get_blocks(&total);
+    hashes = g_try_new(uint64_t, total);
+    if (!hashes) {
+        goto out;
+    }
+    for (i = 0; i < blocks->len; i++) {
+        n += ram_dedup_hash_block(g_ptr_array_index(blocks, i), hashes + n);
+    }
+
+    qsort(hashes, n, sizeof(*hashes), ram_dedup_hash_cmp);
+    for (i = 0, distinct = 0; i < n; i++) {
+        if (i == 0 || hashes[i] != hashes[i - 1]) {
+            distinct++;
+        }
+    }
+    ram_dedup.duplicate_pages = n - distinct;
+
+    /* Pages are hashed again, so changes since the first pass are seen. */
+    if (ram_dedup.merge) {
+        for (i = 0; i < blocks->len; i++) {
+            ram_dedup.hinted +=
+                ram_dedup_hint_block(g_ptr_array_index(blocks, i), hashes, n);
+        }
+    }
+    status = RAM_DEDUP_STATUS_SCANNED;
+
+out:
+    for (i = 0; i < blocks->len; i++) {
+        RAMBlock *block = g_ptr_array_index(blocks, i);
+
+        memory_region_unref(block->mr);
+    }
+    g_free(hashes);
+    qatomic_store_release(&ram_dedup.status, status);
+    rcu_unregister_thread();
+    return NULL;
+}
+
+void qmp_x_calc_ram_dedup(bool has_merge, bool merge, Error **errp)
+{
+    QemuThread thread;
+
+    if (qatomic_read(&ram_dedup.status) == RAM_DEDUP_STATUS_SCANNING) {
+        error_setg(errp, "guest RAM is already being scanned");
+        return;
+    }
+    if (merge && QEMU_MADV_MERGEABLE == QEMU_MADV_INVALID) {
+        error_setg(errp, "Memory merging is not supported on this host");
+        return;
+    }
+
+    ram_dedup.merge = merge;
+    ram_dedup.scanned_pages = 0;
+    ram_dedup.zero_pages = 0;
+    ram_dedup.duplicate_pages = 0;
+    ram_dedup.hinted = 0;
+    qatomic_set(&ram_dedup.status, RAM_DEDUP_STATUS_SCANNING);
+
+    qemu_thread_create(&thread, MIGRATION_THREAD_RAM_DEDUP,
+                       ram_dedup_thread, NULL, QEMU_THREAD_DETACHED);
+}
+
+/* Return the memory KSM currently shares for this process, if known. */
+static bool ram_dedup_get_merged(uint64_t *merged)
+{
+#ifdef CONFIG_LINUX
+    static const char key[] = "ksm_merging_pages ";
+    g_autofree char *stat = NULL;
+    const char *p, *end;
+    uint64_t pages;
+
+    if (!g_file_get_contents("/proc/self/ksm_stat", &stat, NULL, NULL)) {
+        return false;
+    }
+    p = strstr(stat, key);
+    if (!p || qemu_strtou64(p + strlen(key), &end, 10, &pages) < 0) {
+        return false;
+    }
+    *merged = pages * qemu_real_host_page_size();
+    return true;
+#else
+    return false;
+#endif
+}
+
+RamDedupInfo *qmp_x_query_ram_dedup(Error **errp)
+{
+    RamDedupInfo *info = g_new0(RamDedupInfo, 1);
+    uint64_t page_size = qemu_target_page_size();
+
+    info->status = qatomic_load_acquire(&ram_dedup.status);
+    info->scanned_pages = qatomic_read(&ram_dedup.scanned_pages);
+    info->zero_pages = qatomic_read(&ram_dedup.zero_pages);
+    info->page_size = page_size;
+
+    if (info->status == RAM_DEDUP_STATUS_SCANNED) {
+        info->has_duplicate_pages = true;
+        info->duplicate_pages = ram_dedup.duplicate_pages;
+        info->has_savings = true;
+        info->savings = (info->zero_pages + info->duplicate_pages) * page_size;
+        if (ram_dedup.merge) {
+            info->has_hinted = true;
+            info->hinted = ram_dedup.hinted;
+        }
+    }
+    info->has_merged = ram_dedup_get_merged(&info->merged);
+
+    return info;
+}
@@ -949,31 +949,40 @@ static uint64_t physical_memory_sync_dirty_bitmap(RAMBlock *rb,
     if (((word * BITS_PER_LONG) << TARGET_PAGE_BITS) ==
          (start + rb->offset) &&
         !(length & ((BITS_PER_LONG << TARGET_PAGE_BITS) - 1))) {
-        int k;
-        int nr = BITS_TO_LONGS(length >> TARGET_PAGE_BITS);
+        unsigned long nr = BITS_TO_LONGS(length >> TARGET_PAGE_BITS);
         unsigned long * const *src;
         unsigned long idx = (word * BITS_PER_LONG) / DIRTY_MEMORY_BLOCK_SIZE;
         unsigned long offset = BIT_WORD((word * BITS_PER_LONG) %
                                         DIRTY_MEMORY_BLOCK_SIZE);
-        unsigned long page = BIT_WORD(start >> TARGET_PAGE_BITS);
+        unsigned long k = BIT_WORD(start >> TARGET_PAGE_BITS);
 
         src = qatomic_rcu_read(
                 &ram_list.dirty_memory[DIRTY_MEMORY_MIGRATION])->blocks;
 
-        for (k = page; k < page + nr; k++) {
-            if (src[idx][offset]) {
-                unsigned long bits = qatomic_xchg(&src[idx][offset], 0);
+        /* Only visit the words that the summary says were dirtied. */
+        while (nr) {
+            unsigned long *block = src[idx];
+            unsigned long *summary = dirty_memory_block_summary(block);
+            unsigned long n = MIN(nr, DIRTY_MEMORY_BLOCK_WORDS - offset);
+            unsigned long w;
+
+            for (w = find_next_bit(summary, offset + n, offset);
+                 w < offset + n;
+                 w = find_next_bit(summary, offset + n, w + 1)) {
+                unsigned long bits = dirty_memory_block_harvest(block, w);
+                unsigned long *d = &dest[k + w - offset];
                 unsigned long new_dirty;
-                new_dirty = ~dest[k];
-                dest[k] |= bits;
+
+                new_dirty = ~*d;
+                *d |= bits;
                 new_dirty &= bits;
                 num_dirty += ctpopl(new_dirty);
             }
 
-            if (++offset >= BITS_TO_LONGS(DIRTY_MEMORY_BLOCK_SIZE)) {
-                offset = 0;
-                idx++;
-            }
+            k += n;
+            nr -= n;
+            offset = 0;
+            idx++;
         }
         if (num_dirty) {
             physical_memory_dirty_bits_cleared(start, length);
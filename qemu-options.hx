@@ -41,6 +41,7 @@ DEF("machine", HAS_ARG, QEMU_OPTION_machine, \
     "                spcr=on|off controls ACPI SPCR support (default=on)\n"
 #ifdef CONFIG_POSIX
     "                aux-ram-share=on|off allocate auxiliary guest RAM as shared (default: off)\n"
+    "                share-rom=on|off map firmware and option ROM images instead of copying them (default: off)\n"
 #endif
     "                memory-backend='backend-id' specifies explicitly provided backend for main RAM (default=none)\n"
     "                cxl-fmw.0.targets.0=firsttarget,cxl-fmw.0.targets.1=secondtarget,cxl-fmw.0.size=size[,cxl-fmw.0.interleave-granularity=granularity]\n"
@@ -121,6 +122,14 @@ SRST
 
         To use the cpr-transfer migration mode, you must set aux-ram-share=on.
 
+    ``share-rom=on|off``
+        Map the BIOS and PCI option ROM images copy-on-write from their
+        files instead of loading a private copy of each into guest RAM.
+        All guests on a host that use the same images then share one
+        copy of them in the host page cache.  Only images that exactly
+        fill their ROM are mapped; others are loaded as usual.  The
+        default is off.
+
     ``memory-backend='id'``
         An alternative to legacy ``-mem-path`` and ``mem-prealloc`` options.
         Allows to use a memory backend as main RAM.
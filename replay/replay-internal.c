@@ -15,6 +15,7 @@
 #include "replay-internal.h"
 #include "qemu/error-report.h"
 #include "qemu/main-loop.h"
+#include "qemu/units.h"
 #include "trace.h"
 
 /* Mutex to protect reading and writing events to the log.
@@ -31,6 +32,19 @@ static unsigned long mutex_head, mutex_tail;
 static bool write_error;
 FILE *replay_file;
 
+/*
+ * Recording appends to this buffer, which is written out when full,
+ * rather than going through stdio one byte at a time.
+ */
+#define REPLAY_WBUF_SIZE    (256 * KiB)
+static uint8_t *replay_wbuf;
+static size_t replay_wlen;
+
+/* Playback reads the log through a read-only mapping. */
+static GMappedFile *replay_map;
+static const uint8_t *replay_rbuf;
+static size_t replay_rlen, replay_rpos;
+
 static void replay_write_error(void)
 {
     if (!write_error) {
@@ -45,12 +59,38 @@ static void replay_read_error(void)
     exit(1);
 }
 
+void replay_file_flush(void)
+{
+    if (replay_file && replay_wlen) {
+        if (fwrite(replay_wbuf, 1, replay_wlen, replay_file) != replay_wlen) {
+            replay_write_error();
+        }
+        replay_wlen = 0;
+    }
+}
+
+static void replay_write(const uint8_t *buf, size_t size)
+{
+    if (replay_wlen + size > REPLAY_WBUF_SIZE) {
+        replay_file_flush();
+        if (size > REPLAY_WBUF_SIZE) {
+            if (fwrite(buf, 1, size, replay_file) != size) {
+                replay_write_error();
+            }
+            return;
+        }
+    }
+    memcpy(replay_wbuf + replay_wlen, buf, size);
+    replay_wlen += size;
+}
+
 static void replay_putc(uint8_t byte)
 {
     if (replay_file) {
-        if (putc(byte, replay_file) == EOF) {
-            replay_write_error();
+        if (unlikely(replay_wlen == REPLAY_WBUF_SIZE)) {
+            replay_file_flush();
         }
+        replay_wbuf[replay_wlen++] = byte;
     }
 }
 
@@ -99,21 +139,26 @@ void replay_put_array(const uint8_t *buf, size_t size)
 {
     if (replay_file) {
         replay_put_dword(size);
-        if (fwrite(buf, 1, size, replay_file) != size) {
-            replay_write_error();
-        }
+        replay_write(buf, size);
+    }
+}
+
+static const uint8_t *replay_read(size_t size)
+{
+    const uint8_t *p = replay_rbuf + replay_rpos;
+
+    if (size > replay_rlen - replay_rpos) {
+        replay_read_error();
     }
+    replay_rpos += size;
+    return p;
 }
 
 static uint8_t replay_getc(void)
 {
     uint8_t byte = 0;
     if (replay_file) {
-        int r = getc(replay_file);
-        if (r == EOF) {
-            replay_read_error();
-        }
-        byte = r;
+        byte = *replay_read(1);
     }
     return byte;
 }
@@ -171,9 +216,7 @@ void replay_get_array(uint8_t *buf, size_t *size)
 {
     if (replay_file) {
         *size = replay_get_dword();
-        if (fread(buf, 1, *size, replay_file) != *size) {
-            replay_read_error();
-        }
+        memcpy(buf, replay_read(*size), *size);
     }
 }
 
@@ -181,10 +224,59 @@ void replay_get_array_alloc(uint8_t **buf, size_t *size)
 {
     if (replay_file) {
         *size = replay_get_dword();
-        *buf = g_malloc(*size);
-        if (fread(*buf, 1, *size, replay_file) != *size) {
-            replay_read_error();
-        }
+        *buf = g_memdup2(replay_read(*size), *size);
+    }
+}
+
+void replay_file_open(const char *fname, ReplayMode mode)
+{
+    g_autoptr(GError) err = NULL;
+
+    if (mode == REPLAY_MODE_RECORD) {
+        replay_wbuf = g_malloc(REPLAY_WBUF_SIZE);
+        replay_wlen = 0;
+        return;
+    }
+
+    replay_map = g_mapped_file_new(fname, false, &err);
+    if (!replay_map) {
+        error_report("Replay: map %s: %s", fname, err->message);
+        exit(1);
+    }
+    replay_rbuf = (const uint8_t *)g_mapped_file_get_contents(replay_map);
+    replay_rlen = g_mapped_file_get_length(replay_map);
+    replay_rpos = 0;
+}
+
+void replay_file_close(void)
+{
+    replay_file_flush();
+    g_free(replay_wbuf);
+    replay_wbuf = NULL;
+
+    if (replay_map) {
+        g_mapped_file_unref(replay_map);
+        replay_map = NULL;
+        replay_rbuf = NULL;
+        replay_rlen = replay_rpos = 0;
+    }
+}
+
+uint64_t replay_file_tell(void)
+{
+    if (replay_mode == REPLAY_MODE_PLAY) {
+        return replay_rpos;
+    }
+    return ftell(replay_file) + replay_wlen;
+}
+
+void replay_file_seek(uint64_t offset)
+{
+    if (replay_mode == REPLAY_MODE_PLAY) {
+        replay_rpos = MIN(offset, replay_rlen);
+    } else {
+        replay_file_flush();
+        fseek(replay_file, offset, SEEK_SET);
     }
 }
 
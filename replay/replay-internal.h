@@ -103,6 +103,19 @@ extern ReplayState replay_state;
 
 /* File for replay writing */
 extern FILE *replay_file;
+
+/*
+ * Set up buffered writing of, or the mapping for reading, the log
+ * just opened as replay_file.
+ */
+void replay_file_open(const char *fname, ReplayMode mode);
+/* Write out what is buffered and release the buffer or mapping */
+void replay_file_close(void);
+/* Write out the data buffered for recording */
+void replay_file_flush(void);
+/* Position in the log, valid for both recording and playback */
+uint64_t replay_file_tell(void);
+void replay_file_seek(uint64_t offset);
 /* Instruction count of the replay breakpoint */
 extern uint64_t replay_break_icount;
 /* Timer for the replay breakpoint callback */
@@ -363,6 +363,7 @@ static void replay_enable(const char *fname, int mode)
         exit(1);
     }
 
+    replay_file_open(fname, mode);
     replay_filename = g_strdup(fname);
     replay_mode = mode;
     replay_mutex_init();
@@ -375,7 +376,7 @@ static void replay_enable(const char *fname, int mode)
 
     /* skip file header for RECORD and check it for PLAY */
     if (replay_mode == REPLAY_MODE_RECORD) {
-        fseek(replay_file, HEADER_SIZE, SEEK_SET);
+        replay_file_seek(HEADER_SIZE);
     } else if (replay_mode == REPLAY_MODE_PLAY) {
         unsigned int version = replay_get_dword();
         if (version != REPLAY_VERSION) {
@@ -383,7 +384,7 @@ static void replay_enable(const char *fname, int mode)
             exit(1);
         }
         /* go to the beginning */
-        fseek(replay_file, HEADER_SIZE, SEEK_SET);
+        replay_file_seek(HEADER_SIZE);
         replay_fetch_data_kind();
     }
 
@@ -473,10 +474,11 @@ void replay_finish(void)
             replay_put_event(EVENT_END);
 
             /* write header */
-            fseek(replay_file, 0, SEEK_SET);
+            replay_file_seek(0);
             replay_put_dword(REPLAY_VERSION);
         }
 
+        replay_file_close();
         fclose(replay_file);
         replay_file = NULL;
     }
@@ -30,6 +30,8 @@
 #include "system/memory.h"
 #include "system/address-spaces.h"
 #include "hw/core/qdev.h"
+#include "qemu/main-loop.h"
+#include "qemu/rcu.h"
 #include "trace.h"
 
 struct MemoryRegionPortioList {
@@ -59,9 +61,189 @@ const MemoryRegionOps unassigned_io_ops = {
     .endianness = DEVICE_LITTLE_ENDIAN,
 };
 
+/*
+ * Direct dispatch table for address_space_io.  Every port maps to the
+ * section of the current FlatView that contains it, so that accesses
+ * do not need to go through address_space_translate().  The table is
+ * rebuilt by a memory listener whenever the topology changes, and read
+ * under RCU.
+ */
+typedef struct IOPortSection {
+    MemoryRegion *mr;
+    /* Subtract from a port number to get the offset within @mr. */
+    hwaddr delta;
+    /* One past the last port of the section. */
+    uint32_t end;
+} IOPortSection;
+
+typedef struct IOPortDispatch {
+    struct rcu_head rcu;
+    IOPortSection *sections;
+    unsigned nr;
+    /* Index in sections, 0 if the port must take the slow path. */
+    uint16_t map[MAX_IOPORTS];
+} IOPortDispatch;
+
+static IOPortDispatch *ioport_dispatch;
+static IOPortDispatch *ioport_dispatch_next;
+
+static void ioport_dispatch_free(IOPortDispatch *d)
+{
+    unsigned i;
+
+    for (i = 1; i < d->nr; i++) {
+        memory_region_unref(d->sections[i].mr);
+    }
+    g_free(d->sections);
+    g_free(d);
+}
+
+static IOPortDispatch *ioport_dispatch_get_next(void)
+{
+    if (!ioport_dispatch_next) {
+        ioport_dispatch_next = g_new0(IOPortDispatch, 1);
+        ioport_dispatch_next->nr = 1;
+    }
+    return ioport_dispatch_next;
+}
+
+static void ioport_dispatch_add_section(MemoryListener *listener,
+                                        MemoryRegionSection *section)
+{
+    IOPortDispatch *d = ioport_dispatch_get_next();
+    uint64_t start = section->offset_within_address_space;
+    uint64_t end = start + int128_get64(section->size);
+    IOPortSection *s;
+    uint64_t port;
+
+    /* RAM is accessed directly, leave it to address_space_rw(). */
+    if (memory_region_supports_direct_access(section->mr) ||
+        start >= MAX_IOPORTS || d->nr > UINT16_MAX) {
+        return;
+    }
+
+    d->sections = g_renew(IOPortSection, d->sections, d->nr + 1);
+    s = &d->sections[d->nr];
+    s->mr = section->mr;
+    s->delta = start - section->offset_within_region;
+    s->end = MIN(end, MAX_IOPORTS);
+    memory_region_ref(s->mr);
+
+    for (port = start; port < s->end; port++) {
+        d->map[port] = d->nr;
+    }
+    d->nr++;
+}
+
+static void ioport_dispatch_del_section(MemoryListener *listener,
+                                        MemoryRegionSection *section)
+{
+    ioport_dispatch_get_next();
+}
+
+static void ioport_dispatch_begin(MemoryListener *listener)
+{
+    assert(!ioport_dispatch_next);
+}
+
+static void ioport_dispatch_commit(MemoryListener *listener)
+{
+    IOPortDispatch *old;
+
+    /* begin and commit also run when another address space changed. */
+    if (!ioport_dispatch_next) {
+        return;
+    }
+
+    old = qatomic_xchg(&ioport_dispatch, ioport_dispatch_next);
+    ioport_dispatch_next = NULL;
+    if (old) {
+        call_rcu(old, ioport_dispatch_free, rcu);
+    }
+}
+
+static MemoryListener ioport_dispatch_listener = {
+    .name = "ioport-dispatch",
+    .begin = ioport_dispatch_begin,
+    .commit = ioport_dispatch_commit,
+    .region_add = ioport_dispatch_add_section,
+    .region_nop = ioport_dispatch_add_section,
+    .region_del = ioport_dispatch_del_section,
+};
+
+void ioport_dispatch_init(void)
+{
+    memory_listener_register(&ioport_dispatch_listener, &address_space_io);
+}
+
+/*
+ * Return the section that covers all of [@port, @port + @size) and can
+ * take the access in one go, or NULL.  Called within RCU critical
+ * section.
+ */
+static const IOPortSection *ioport_dispatch_find(uint32_t port,
+                                                 unsigned size)
+{
+    IOPortDispatch *d = qatomic_rcu_read(&ioport_dispatch);
+    const IOPortSection *s;
+
+    if (!d || port >= MAX_IOPORTS) {
+        return NULL;
+    }
+    s = &d->sections[d->map[port]];
+    if (!s->mr || port + size > s->end ||
+        memory_access_size(s->mr, size, port - s->delta) < size) {
+        return NULL;
+    }
+    return s;
+}
+
+bool ioport_dispatch_read(uint32_t port, MemOp op, uint64_t *pval,
+                          MemTxAttrs attrs)
+{
+    const IOPortSection *s;
+    bool release_lock;
+
+    RCU_READ_LOCK_GUARD();
+    s = ioport_dispatch_find(port, memop_size(op));
+    if (!s) {
+        return false;
+    }
+
+    release_lock = prepare_mmio_access(s->mr);
+    memory_region_dispatch_read(s->mr, port - s->delta, pval, op, attrs);
+    if (release_lock) {
+        bql_unlock();
+    }
+    return true;
+}
+
+bool ioport_dispatch_write(uint32_t port, MemOp op, uint64_t val,
+                           MemTxAttrs attrs)
+{
+    const IOPortSection *s;
+    bool release_lock;
+
+    RCU_READ_LOCK_GUARD();
+    s = ioport_dispatch_find(port, memop_size(op));
+    if (!s) {
+        return false;
+    }
+
+    release_lock = prepare_mmio_access(s->mr);
+    memory_region_dispatch_write(s->mr, port - s->delta, val, op, attrs);
+    if (release_lock) {
+        bql_unlock();
+    }
+    return true;
+}
+
 void cpu_outb(uint32_t addr, uint8_t val)
 {
     trace_cpu_out(addr, 'b', val);
+    if (ioport_dispatch_write(addr, MO_UB, val, MEMTXATTRS_UNSPECIFIED)) {
+        return;
+    }
     address_space_stb(&address_space_io, addr, val,
                       MEMTXATTRS_UNSPECIFIED, NULL);
 }
@@ -69,6 +251,9 @@ void cpu_outb(uint32_t addr, uint8_t val)
 void cpu_outw(uint32_t addr, uint16_t val)
 {
     trace_cpu_out(addr, 'w', val);
+    if (ioport_dispatch_write(addr, MO_LEUW, val, MEMTXATTRS_UNSPECIFIED)) {
+        return;
+    }
     address_space_stw_le(&address_space_io, addr, val,
                          MEMTXATTRS_UNSPECIFIED, NULL);
 }
@@ -76,36 +261,45 @@ void cpu_outw(uint32_t addr, uint16_t val)
 void cpu_outl(uint32_t addr, uint32_t val)
 {
     trace_cpu_out(addr, 'l', val);
+    if (ioport_dispatch_write(addr, MO_LEUL, val, MEMTXATTRS_UNSPECIFIED)) {
+        return;
+    }
     address_space_stl_le(&address_space_io, addr, val,
                          MEMTXATTRS_UNSPECIFIED, NULL);
 }
 
 uint8_t cpu_inb(uint32_t addr)
 {
-    uint8_t val;
+    uint64_t val;
 
-    val = address_space_ldub(&address_space_io, addr,
-                             MEMTXATTRS_UNSPECIFIED, NULL);
+    if (!ioport_dispatch_read(addr, MO_UB, &val, MEMTXATTRS_UNSPECIFIED)) {
+        val = address_space_ldub(&address_space_io, addr,
+                                 MEMTXATTRS_UNSPECIFIED, NULL);
+    }
     trace_cpu_in(addr, 'b', val);
     return val;
 }
 
 uint16_t cpu_inw(uint32_t addr)
 {
-    uint16_t val;
+    uint64_t val;
 
-    val = address_space_lduw_le(&address_space_io, addr,
-                                MEMTXATTRS_UNSPECIFIED, NULL);
+    if (!ioport_dispatch_read(addr, MO_LEUW, &val, MEMTXATTRS_UNSPECIFIED)) {
+        val = address_space_lduw_le(&address_space_io, addr,
+                                    MEMTXATTRS_UNSPECIFIED, NULL);
+    }
     trace_cpu_in(addr, 'w', val);
     return val;
 }
 
 uint32_t cpu_inl(uint32_t addr)
 {
-    uint32_t val;
+    uint64_t val;
 
-    val = address_space_ldl_le(&address_space_io, addr,
-                               MEMTXATTRS_UNSPECIFIED, NULL);
+    if (!ioport_dispatch_read(addr, MO_LEUL, &val, MEMTXATTRS_UNSPECIFIED)) {
+        val = address_space_ldl_le(&address_space_io, addr,
+                                   MEMTXATTRS_UNSPECIFIED, NULL);
+    }
     trace_cpu_in(addr, 'l', val);
     return val;
 }
@@ -28,6 +28,7 @@
 #include "system/physmem.h"
 #include "system/ramblock.h"
 #include "system/kvm.h"
+#include "system/replay.h"
 #include "system/runstate.h"
 #include "system/tcg.h"
 #include "qemu/accel.h"
@@ -42,6 +43,11 @@
 
 static unsigned memory_region_transaction_depth;
 static bool memory_region_update_pending;
+/*
+ * The regions whose rendering changed in the current transaction, or
+ * NULL if all FlatViews must be regenerated.
+ */
+static GHashTable *memory_region_update_dirty;
 static bool ioeventfd_update_pending;
 unsigned int global_dirty_tracking;
 
@@ -513,6 +519,36 @@ static MemTxResult memory_region_write_with_attrs_accessor(MemoryRegion *mr,
     return mr->ops->write_with_attrs(mr->opaque, addr, tmp, size, attrs);
 }
 
+/*
+ * Do not allow more than one simultaneous access to a device's IO Regions.
+ * Return false if @mr is already being accessed, else set *@guarded if
+ * memory_region_io_exit() has something to undo.
+ */
+static inline bool memory_region_io_enter(MemoryRegion *mr, hwaddr addr,
+                                          bool *guarded)
+{
+    *guarded = false;
+    if (mr->dev && !mr->disable_reentrancy_guard &&
+        !mr->ram_device && !mr->ram && !mr->rom_device && !mr->readonly) {
+        if (mr->dev->mem_reentrancy_guard.engaged_in_io) {
+            warn_report_once("Blocked re-entrant IO on MemoryRegion: "
+                             "%s at addr: 0x%" HWADDR_PRIX,
+                             memory_region_name(mr), addr);
+            return false;
+        }
+        mr->dev->mem_reentrancy_guard.engaged_in_io = true;
+        *guarded = true;
+    }
+    return true;
+}
+
+static inline void memory_region_io_exit(MemoryRegion *mr, bool guarded)
+{
+    if (guarded) {
+        mr->dev->mem_reentrancy_guard.engaged_in_io = false;
+    }
+}
+
 static MemTxResult access_with_adjusted_size(hwaddr addr,
                                       uint64_t *value,
                                       unsigned size,
@@ -533,7 +569,7 @@ static MemTxResult access_with_adjusted_size(hwaddr addr,
     unsigned access_size;
     unsigned i;
     MemTxResult r = MEMTX_OK;
-    bool reentrancy_guard_applied = false;
+    bool reentrancy_guard_applied;
 
     if (!access_size_min) {
         access_size_min = 1;
@@ -542,17 +578,8 @@ static MemTxResult access_with_adjusted_size(hwaddr addr,
         access_size_max = 4;
     }
 
-    /* Do not allow more than one simultaneous access to a device's IO Regions */
-    if (mr->dev && !mr->disable_reentrancy_guard &&
-        !mr->ram_device && !mr->ram && !mr->rom_device && !mr->readonly) {
-        if (mr->dev->mem_reentrancy_guard.engaged_in_io) {
-            warn_report_once("Blocked re-entrant IO on MemoryRegion: "
-                             "%s at addr: 0x%" HWADDR_PRIX,
-                             memory_region_name(mr), addr);
-            return MEMTX_ACCESS_ERROR;
-        }
-        mr->dev->mem_reentrancy_guard.engaged_in_io = true;
-        reentrancy_guard_applied = true;
+    if (!memory_region_io_enter(mr, addr, &reentrancy_guard_applied)) {
+        return MEMTX_ACCESS_ERROR;
     }
 
     /* FIXME: support unaligned access? */
@@ -569,9 +596,85 @@ static MemTxResult access_with_adjusted_size(hwaddr addr,
                         access_mask, attrs);
         }
     }
-    if (mr->dev && reentrancy_guard_applied) {
-        mr->dev->mem_reentrancy_guard.engaged_in_io = false;
+    memory_region_io_exit(mr, reentrancy_guard_applied);
+    return r;
+}
+
+/* Return whether the device implements accesses of @size bytes itself. */
+static inline bool memory_region_access_is_native(MemoryRegion *mr,
+                                                  unsigned size)
+{
+    unsigned access_size_min = mr->ops->impl.min_access_size ?: 1;
+    unsigned access_size_max = mr->ops->impl.max_access_size ?: 4;
+
+    return size >= access_size_min && size <= access_size_max;
+}
+
+/*
+ * Fast paths for accesses that need no splitting: a single call to the
+ * device, without going through an accessor and shifting the value.
+ */
+static MemTxResult memory_region_read_native(MemoryRegion *mr,
+                                             hwaddr addr,
+                                             uint64_t *pval,
+                                             unsigned size,
+                                             MemTxAttrs attrs)
+{
+    uint64_t tmp = 0;
+    MemTxResult r = MEMTX_OK;
+    bool guarded;
+
+    if (!memory_region_io_enter(mr, addr, &guarded)) {
+        return MEMTX_ACCESS_ERROR;
     }
+
+    if (mr->ops->read) {
+        tmp = mr->ops->read(mr->opaque, addr, size);
+    } else {
+        r = mr->ops->read_with_attrs(mr->opaque, addr, &tmp, size, attrs);
+    }
+    if (mr->subpage) {
+        trace_memory_region_subpage_read(get_cpu_index(), mr, addr, tmp, size);
+    } else if (trace_event_get_state_backends(TRACE_MEMORY_REGION_OPS_READ)) {
+        hwaddr abs_addr = memory_region_to_absolute_addr(mr, addr);
+        trace_memory_region_ops_read(get_cpu_index(), mr, abs_addr, tmp, size,
+                                     memory_region_name(mr));
+    }
+    *pval = tmp & MAKE_64BIT_MASK(0, size * 8);
+
+    memory_region_io_exit(mr, guarded);
+    return r;
+}
+
+static MemTxResult memory_region_write_native(MemoryRegion *mr,
+                                              hwaddr addr,
+                                              uint64_t data,
+                                              unsigned size,
+                                              MemTxAttrs attrs)
+{
+    MemTxResult r = MEMTX_OK;
+    bool guarded;
+
+    if (!memory_region_io_enter(mr, addr, &guarded)) {
+        return MEMTX_ACCESS_ERROR;
+    }
+
+    data &= MAKE_64BIT_MASK(0, size * 8);
+    if (mr->subpage) {
+        trace_memory_region_subpage_write(get_cpu_index(), mr, addr, data,
+                                          size);
+    } else if (trace_event_get_state_backends(TRACE_MEMORY_REGION_OPS_WRITE)) {
+        hwaddr abs_addr = memory_region_to_absolute_addr(mr, addr);
+        trace_memory_region_ops_write(get_cpu_index(), mr, abs_addr, data,
+                                      size, memory_region_name(mr));
+    }
+    if (mr->ops->write) {
+        mr->ops->write(mr->opaque, addr, data, size);
+    } else {
+        r = mr->ops->write_with_attrs(mr->opaque, addr, data, size, attrs);
+    }
+
+    memory_region_io_exit(mr, guarded);
     return r;
 }
 
@@ -1057,26 +1160,94 @@ static void flatviews_init(void)
     }
 }
 
+/*
+ * Record that the rendering of @mr changed if @pending, so that the
+ * FlatViews from which @mr can be reached are regenerated at the end
+ * of the transaction.  A NULL @mr affects all FlatViews.
+ */
+static void memory_region_set_update_pending(MemoryRegion *mr, bool pending)
+{
+    if (!pending) {
+        return;
+    }
+
+    if (!memory_region_update_pending) {
+        memory_region_update_pending = true;
+        memory_region_update_dirty = g_hash_table_new(NULL, NULL);
+    }
+    if (!mr) {
+        g_clear_pointer(&memory_region_update_dirty, g_hash_table_unref);
+    } else if (memory_region_update_dirty) {
+        g_hash_table_add(memory_region_update_dirty, mr);
+    }
+}
+
+/*
+ * Return whether a region changed in the current transaction can be
+ * reached from @mr.  The answer for every region visited is cached in
+ * @seen, because subtrees are commonly shared between FlatViews through
+ * aliases.
+ */
+static bool memory_region_update_affects(MemoryRegion *mr, GHashTable *seen)
+{
+    gpointer cached = g_hash_table_lookup(seen, mr);
+    MemoryRegion *subregion;
+    bool affected = false;
+
+    if (cached) {
+        return cached == GINT_TO_POINTER(1);
+    }
+
+    if (g_hash_table_contains(memory_region_update_dirty, mr)) {
+        affected = true;
+    } else if (mr->enabled) {
+        if (mr->alias) {
+            affected = memory_region_update_affects(mr->alias, seen);
+        }
+        QTAILQ_FOREACH(subregion, &mr->subregions, subregions_link) {
+            if (affected) {
+                break;
+            }
+            affected = memory_region_update_affects(subregion, seen);
+        }
+    }
+
+    g_hash_table_insert(seen, mr, GINT_TO_POINTER(affected ? 1 : 2));
+    return affected;
+}
+
 static void flatviews_reset(void)
 {
+    g_autoptr(GHashTable) old_views = g_steal_pointer(&flat_views);
+    g_autoptr(GHashTable) seen = g_hash_table_new(NULL, NULL);
     AddressSpace *as;
 
-    if (flat_views) {
-        g_hash_table_unref(flat_views);
-        flat_views = NULL;
-    }
     flatviews_init();
 
-    /* Render unique FVs */
+    /*
+     * Render unique FVs.  Those that cannot reach any region changed in
+     * this transaction are carried over unchanged.
+     */
     QTAILQ_FOREACH(as, &address_spaces, address_spaces_link) {
         MemoryRegion *physmr = memory_region_get_flatview_root(as->root);
+        FlatView *view;
 
         if (g_hash_table_lookup(flat_views, physmr)) {
             continue;
         }
 
+        view = old_views ? g_hash_table_lookup(old_views, physmr) : NULL;
+        if (view && memory_region_update_dirty &&
+            !memory_region_update_affects(physmr, seen)) {
+            flatview_ref(view);
+            g_hash_table_replace(flat_views, physmr, view);
+            continue;
+        }
+
         generate_memory_topology(physmr);
     }
+
+    g_clear_pointer(&memory_region_update_dirty, g_hash_table_unref);
 }
 
 static void address_space_set_flatview(AddressSpace *as)
@@ -1109,6 +1280,7 @@ static void address_space_set_flatview(AddressSpace *as)
 
     /* Writes are protected by the BQL.  */
     qatomic_rcu_set(&as->current_map, new_view);
+    qatomic_store_release(&as->dma_cache_gen, as->dma_cache_gen + 1);
     if (old_view) {
         flatview_unref(old_view);
     }
@@ -1447,6 +1619,10 @@ static MemTxResult memory_region_dispatch_read1(MemoryRegion *mr,
                                                 unsigned size,
                                                 MemTxAttrs attrs)
 {
+    if (likely(memory_region_access_is_native(mr, size))) {
+        return memory_region_read_native(mr, addr, pval, size, attrs);
+    }
+
     *pval = 0;
 
     if (mr->ops->read) {
@@ -1482,6 +1658,9 @@ MemTxResult memory_region_dispatch_read(MemoryRegion *mr,
         *pval = unassigned_mem_read(mr, addr, size);
         return MEMTX_DECODE_ERROR;
     }
+    if (mr->flush_coalesced_mmio) {
+        memory_region_flush_coalesced_tcg();
+    }
 
     r = memory_region_dispatch_read1(mr, addr, pval, size, attrs);
     adjust_endianness(mr, pval, op);
@@ -1514,6 +1693,118 @@ static bool memory_region_dispatch_write_eventfds(MemoryRegion *mr,
     return false;
 }
 
+static MemTxResult memory_region_dispatch_write1(MemoryRegion *mr,
+                                                 hwaddr addr,
+                                                 uint64_t data,
+                                                 unsigned size,
+                                                 MemTxAttrs attrs)
+{
+    if (likely(memory_region_access_is_native(mr, size))) {
+        return memory_region_write_native(mr, addr, data, size, attrs);
+    }
+
+    if (mr->ops->write) {
+        return access_with_adjusted_size(addr, &data, size,
+                                         mr->ops->impl.min_access_size,
+                                         mr->ops->impl.max_access_size,
+                                         memory_region_write_accessor, mr,
+                                         attrs);
+    } else {
+        return
+            access_with_adjusted_size(addr, &data, size,
+                                      mr->ops->impl.min_access_size,
+                                      mr->ops->impl.max_access_size,
+                                      memory_region_write_with_attrs_accessor,
+                                      mr, attrs);
+    }
+}
+
+/*
+ * Under TCG, writes to coalesced ranges are queued here and performed
+ * when the buffer is flushed, like KVM does with its coalesced MMIO
+ * ring.  The buffer is flushed before any other access to a region
+ * that asked for it with memory_region_set_flush_coalesced(), when it
+ * is full, when a vCPU leaves the execution loop, and by
+ * qemu_flush_coalesced_mmio_buffer().  Protected by the BQL.
+ */
+#define TCG_COALESCED_MMIO_MAX 256
+
+typedef struct CoalescedWrite {
+    MemoryRegion *mr;
+    hwaddr addr;
+    uint64_t data;
+    unsigned size;
+    MemTxAttrs attrs;
+} CoalescedWrite;
+
+static CoalescedWrite tcg_coalesced_mmio[TCG_COALESCED_MMIO_MAX];
+static unsigned tcg_coalesced_mmio_nr;
+static bool tcg_coalesced_mmio_flush_in_progress;
+
+void memory_region_flush_coalesced_tcg(void)
+{
+    unsigned i;
+
+    if (!qatomic_read(&tcg_coalesced_mmio_nr) ||
+        tcg_coalesced_mmio_flush_in_progress) {
+        return;
+    }
+    assert(bql_locked());
+
+    tcg_coalesced_mmio_flush_in_progress = true;
+    for (i = 0; i < tcg_coalesced_mmio_nr; i++) {
+        CoalescedWrite *w = &tcg_coalesced_mmio[i];
+
+        memory_region_dispatch_write1(w->mr, w->addr, w->data, w->size,
+                                      w->attrs);
+        memory_region_unref(w->mr);
+    }
+    qatomic_set(&tcg_coalesced_mmio_nr, 0);
+    tcg_coalesced_mmio_flush_in_progress = false;
+}
+
+/* Return true if the write was queued in the coalesced MMIO buffer */
+static bool memory_region_dispatch_write_coalesced(MemoryRegion *mr,
+                                                   hwaddr addr,
+                                                   uint64_t data,
+                                                   unsigned size,
+                                                   MemTxAttrs attrs)
+{
+    AddrRange access = addrrange_make(int128_make64(addr),
+                                      int128_make64(size));
+    CoalescedMemoryRange *cmr;
+    CoalescedWrite *w;
+
+    if (QTAILQ_EMPTY(&mr->coalesced) || !tcg_enabled() ||
+        replay_mode != REPLAY_MODE_NONE || !bql_locked() ||
+        tcg_coalesced_mmio_flush_in_progress) {
+        return false;
+    }
+
+    QTAILQ_FOREACH(cmr, &mr->coalesced, link) {
+        if (int128_ge(access.start, cmr->addr.start) &&
+            int128_le(addrrange_end(access), addrrange_end(cmr->addr))) {
+            break;
+        }
+    }
+    if (!cmr) {
+        return false;
+    }
+
+    if (tcg_coalesced_mmio_nr == TCG_COALESCED_MMIO_MAX) {
+        memory_region_flush_coalesced_tcg();
+    }
+    w = &tcg_coalesced_mmio[tcg_coalesced_mmio_nr];
+    w->mr = mr;
+    w->addr = addr;
+    w->data = data;
+    w->size = size;
+    w->attrs = attrs;
+    memory_region_ref(mr);
+    qatomic_set(&tcg_coalesced_mmio_nr, tcg_coalesced_mmio_nr + 1);
+    return true;
+}
+
 MemTxResult memory_region_dispatch_write(MemoryRegion *mr,
                                          hwaddr addr,
                                          uint64_t data,
@@ -1544,20 +1835,14 @@ MemTxResult memory_region_dispatch_write(MemoryRegion *mr,
         return MEMTX_OK;
     }
 
-    if (mr->ops->write) {
-        return access_with_adjusted_size(addr, &data, size,
-                                         mr->ops->impl.min_access_size,
-                                         mr->ops->impl.max_access_size,
-                                         memory_region_write_accessor, mr,
-                                         attrs);
-    } else {
-        return
-            access_with_adjusted_size(addr, &data, size,
-                                      mr->ops->impl.min_access_size,
-                                      mr->ops->impl.max_access_size,
-                                      memory_region_write_with_attrs_accessor,
-                                      mr, attrs);
+    if (memory_region_dispatch_write_coalesced(mr, addr, data, size, attrs)) {
+        return MEMTX_OK;
+    }
+    if (mr->flush_coalesced_mmio) {
+        memory_region_flush_coalesced_tcg();
     }
+
+    return memory_region_dispatch_write1(mr, addr, data, size, attrs);
 }
 
 static void memory_region_set_ops(MemoryRegion *mr,
@@ -2180,7 +2465,7 @@ void memory_region_set_log(MemoryRegion *mr, bool log, unsigned client)
 
     memory_region_transaction_begin();
     mr->dirty_log_mask = (mr->dirty_log_mask & ~mask) | (log * mask);
-    memory_region_update_pending |= mr->enabled;
+    memory_region_set_update_pending(mr, mr->enabled);
     memory_region_transaction_commit();
 }
 
@@ -2310,7 +2595,7 @@ void memory_region_set_readonly(MemoryRegion *mr, bool readonly)
     if (mr->readonly != readonly) {
         memory_region_transaction_begin();
         mr->readonly = readonly;
-        memory_region_update_pending |= mr->enabled;
+        memory_region_set_update_pending(mr, mr->enabled);
         memory_region_transaction_commit();
     }
 }
@@ -2320,7 +2605,7 @@ void memory_region_set_nonvolatile(MemoryRegion *mr, bool nonvolatile)
     if (mr->nonvolatile != nonvolatile) {
         memory_region_transaction_begin();
         mr->nonvolatile = nonvolatile;
-        memory_region_update_pending |= mr->enabled;
+        memory_region_set_update_pending(mr, mr->enabled);
         memory_region_transaction_commit();
     }
 }
@@ -2330,7 +2615,7 @@ void memory_region_rom_device_set_romd(MemoryRegion *mr, bool romd_mode)
     if (mr->romd_mode != romd_mode) {
         memory_region_transaction_begin();
         mr->romd_mode = romd_mode;
-        memory_region_update_pending |= mr->enabled;
+        memory_region_set_update_pending(mr, mr->enabled);
         memory_region_transaction_commit();
     }
 }
@@ -2586,7 +2871,7 @@ static void memory_region_update_container_subregions(MemoryRegion *subregion)
     }
     QTAILQ_INSERT_TAIL(&mr->subregions, subregion, subregions_link);
 done:
-    memory_region_update_pending |= mr->enabled && subregion->enabled;
+    memory_region_set_update_pending(mr, mr->enabled && subregion->enabled);
     memory_region_transaction_commit();
 }
 
@@ -2640,7 +2925,7 @@ void memory_region_del_subregion(MemoryRegion *mr,
         memory_region_unref(subregion);
     }
 
-    memory_region_update_pending |= mr->enabled && subregion->enabled;
+    memory_region_set_update_pending(mr, mr->enabled && subregion->enabled);
     memory_region_transaction_commit();
 }
 
@@ -2651,7 +2936,7 @@ void memory_region_set_enabled(MemoryRegion *mr, bool enabled)
     }
     memory_region_transaction_begin();
     mr->enabled = enabled;
-    memory_region_update_pending = true;
+    memory_region_set_update_pending(mr, true);
     memory_region_transaction_commit();
 }
 
@@ -2667,7 +2952,7 @@ void memory_region_set_size(MemoryRegion *mr, uint64_t size)
     }
     memory_region_transaction_begin();
     mr->size = s;
-    memory_region_update_pending = true;
+    memory_region_set_update_pending(mr, true);
     memory_region_transaction_commit();
 }
 
@@ -2703,7 +2988,7 @@ void memory_region_set_alias_offset(MemoryRegion *mr, hwaddr offset)
 
     memory_region_transaction_begin();
     mr->alias_offset = offset;
-    memory_region_update_pending |= mr->enabled;
+    memory_region_set_update_pending(mr, mr->enabled);
     memory_region_transaction_commit();
 }
 
@@ -2715,7 +3000,7 @@ void memory_region_set_unmergeable(MemoryRegion *mr, bool unmergeable)
 
     memory_region_transaction_begin();
     mr->unmergeable = unmergeable;
-    memory_region_update_pending |= mr->enabled;
+    memory_region_set_update_pending(mr, mr->enabled);
     memory_region_transaction_commit();
 }
 
@@ -2914,7 +3199,7 @@ bool memory_global_dirty_log_start(unsigned int flags, Error **errp)
         }
 
         memory_region_transaction_begin();
-        memory_region_update_pending = true;
+        memory_region_set_update_pending(NULL, true);
         memory_region_transaction_commit();
     }
     return true;
@@ -2930,7 +3215,7 @@ static void memory_global_dirty_log_do_stop(unsigned int flags)
 
     if (!global_dirty_tracking) {
         memory_region_transaction_begin();
-        memory_region_update_pending = true;
+        memory_region_set_update_pending(NULL, true);
         memory_region_transaction_commit();
         MEMORY_LISTENER_CALL_GLOBAL(log_global_stop, Reverse);
     }
@@ -3170,6 +3455,8 @@ void address_space_init(AddressSpace *as, MemoryRegion *root, const char *name)
     QTAILQ_INSERT_TAIL(&address_spaces, as, address_spaces_link);
     as->max_bounce_buffer_size = DEFAULT_MAX_BOUNCE_BUFFER_SIZE;
     as->bounce_buffer_size = 0;
+    as->dma_cache = NULL;
+    as->dma_cache_gen = 0;
     qemu_mutex_init(&as->map_client_list_lock);
     QLIST_INIT(&as->map_client_list);
     as->name = g_strdup(name ? name : "anonymous");
@@ -3186,6 +3473,7 @@ static void do_address_space_destroy(AddressSpace *as)
     assert(QTAILQ_EMPTY(&as->listeners));
 
     flatview_unref(as->current_map);
+    g_free(as->dma_cache);
     g_free(as->name);
     g_free(as->ioeventfds);
     memory_region_unref(as->root);
@@ -1012,6 +1012,27 @@ void physical_memory_set_dirty_flag(ram_addr_t addr, unsigned client)
     blocks = qatomic_rcu_read(&ram_list.dirty_memory[client]);
 
     set_bit_atomic(offset, blocks->blocks[idx]);
+    set_bit_atomic(BIT_WORD(offset),
+                   dirty_memory_block_summary(blocks->blocks[idx]));
+}
+
+/* Set @num bits from @offset in @block, then mark their words dirty. */
+static void dirty_memory_block_set(unsigned long *block, unsigned long offset,
+                                   unsigned long num)
+{
+    unsigned long first = BIT_WORD(offset);
+
+    bitmap_set_atomic(block, offset, num);
+    bitmap_set_atomic(dirty_memory_block_summary(block), first,
+                      BIT_WORD(offset + num - 1) - first + 1);
+}
+
+/* OR @bits into word @word of @block, then mark the word dirty. */
+static void dirty_memory_block_or(unsigned long *block, unsigned long word,
+                                  unsigned long bits)
+{
+    qatomic_or(&block[word], bits);
+    set_bit_atomic(word, dirty_memory_block_summary(block));
 }
 
 void physical_memory_set_dirty_range(ram_addr_t start, ram_addr_t length,
@@ -1041,16 +1062,19 @@ void physical_memory_set_dirty_range(ram_addr_t start, ram_addr_t length,
             unsigned long next = MIN(end, base + DIRTY_MEMORY_BLOCK_SIZE);
 
             if (likely(mask & (1 << DIRTY_MEMORY_MIGRATION))) {
-                bitmap_set_atomic(blocks[DIRTY_MEMORY_MIGRATION]->blocks[idx],
-                                  offset, next - page);
+                dirty_memory_block_set(
+                    blocks[DIRTY_MEMORY_MIGRATION]->blocks[idx],
+                    offset, next - page);
             }
             if (unlikely(mask & (1 << DIRTY_MEMORY_VGA))) {
-                bitmap_set_atomic(blocks[DIRTY_MEMORY_VGA]->blocks[idx],
-                                  offset, next - page);
+                dirty_memory_block_set(
+                    blocks[DIRTY_MEMORY_VGA]->blocks[idx],
+                    offset, next - page);
             }
             if (unlikely(mask & (1 << DIRTY_MEMORY_CODE))) {
-                bitmap_set_atomic(blocks[DIRTY_MEMORY_CODE]->blocks[idx],
-                                  offset, next - page);
+                dirty_memory_block_set(
+                    blocks[DIRTY_MEMORY_CODE]->blocks[idx],
+                    offset, next - page);
             }
 
             page = next;
@@ -1105,10 +1129,28 @@ uint64_t physical_memory_test_and_clear_dirty(ram_addr_t start,
         while (page < end) {
             unsigned long idx = page / DIRTY_MEMORY_BLOCK_SIZE;
             unsigned long offset = page % DIRTY_MEMORY_BLOCK_SIZE;
+            unsigned long *block = blocks->blocks[idx];
+            unsigned long bits, n;
 
-            if (bitmap_test_and_clear_atomic(blocks->blocks[idx], offset, 1)) {
+            /* If no page in this word was dirtied, skip all of it. */
+            if (!test_bit(BIT_WORD(offset),
+                          dirty_memory_block_summary(block))) {
+                page = MIN(end, QEMU_ALIGN_UP(page + 1, BITS_PER_LONG));
+                continue;
+            }
+
+            if (offset % BITS_PER_LONG == 0 && end - page >= BITS_PER_LONG) {
+                bits = dirty_memory_block_harvest(block, BIT_WORD(offset));
+                n = BITS_PER_LONG;
+            } else {
+                bits = bitmap_test_and_clear_atomic(block, offset, 1);
+                n = 1;
+            }
+
+            for (; bits; bits &= bits - 1) {
                 if (bmap) {
-                    unsigned long k = page - (ramblock->offset >> TARGET_PAGE_BITS);
+                    unsigned long k = page + ctzl(bits) -
+                                      (ramblock->offset >> TARGET_PAGE_BITS);
                     if (!test_and_set_bit(k, bmap)) {
                         num_dirty++;
                     }
@@ -1117,7 +1159,7 @@ uint64_t physical_memory_test_and_clear_dirty(ram_addr_t start,
                 }
             }
 
-            page++;
+            page += n;
         }
 
         mr_offset = (ram_addr_t)(start_page << TARGET_PAGE_BITS) - ramblock->offset;
@@ -1174,13 +1216,20 @@ DirtyBitmapSnapshot *physical_memory_snapshot_and_clear_dirty
             unsigned long num = MIN(end - page,
                                     DIRTY_MEMORY_BLOCK_SIZE - ofs);
 
+            unsigned long *block = blocks->blocks[idx];
+            unsigned long *summary = dirty_memory_block_summary(block);
+            unsigned long w, nw;
+
             assert(QEMU_IS_ALIGNED(ofs, (1 << BITS_PER_LEVEL)));
             assert(QEMU_IS_ALIGNED(num,    (1 << BITS_PER_LEVEL)));
             ofs >>= BITS_PER_LEVEL;
+            nw = ofs + (num >> BITS_PER_LEVEL);
 
-            bitmap_copy_and_clear_atomic(snap->dirty + dest,
-                                         blocks->blocks[idx] + ofs,
-                                         num);
+            for (w = find_next_bit(summary, nw, ofs); w < nw;
+                 w = find_next_bit(summary, nw, w + 1)) {
+                snap->dirty[dest + w - ofs] =
+                    dirty_memory_block_harvest(block, w);
+            }
             page += num;
             dest += num >> BITS_PER_LEVEL;
         }
@@ -1252,12 +1301,13 @@ uint64_t physical_memory_set_dirty_lebitmap(unsigned long *bitmap,
                                                   sizeof(bitmap[k]));
 
                     nbits = ctpopl(temp);
-                    qatomic_or(&blocks[DIRTY_MEMORY_VGA][idx][offset], temp);
+                    dirty_memory_block_or(blocks[DIRTY_MEMORY_VGA][idx],
+                                          offset, temp);
 
                     if (global_dirty_tracking) {
-                        qatomic_or(
-                                &blocks[DIRTY_MEMORY_MIGRATION][idx][offset],
-                                temp);
+                        dirty_memory_block_or(
+                                blocks[DIRTY_MEMORY_MIGRATION][idx],
+                                offset, temp);
                         if (unlikely(
                             global_dirty_tracking & GLOBAL_DIRTY_DIRTY_RATE)) {
                             total_dirty_pages += nbits;
@@ -1267,8 +1317,8 @@ uint64_t physical_memory_set_dirty_lebitmap(unsigned long *bitmap,
                     num_dirty += nbits;
 
                     if (tcg_enabled()) {
-                        qatomic_or(&blocks[DIRTY_MEMORY_CODE][idx][offset],
-                                   temp);
+                        dirty_memory_block_or(blocks[DIRTY_MEMORY_CODE][idx],
+                                              offset, temp);
                     }
                 }
 
@@ -1449,8 +1499,11 @@ void flatview_add_to_dispatch(FlatView *fv, MemoryRegionSection *section)
 
 void qemu_flush_coalesced_mmio_buffer(void)
 {
-    if (kvm_enabled())
+    if (kvm_enabled()) {
         kvm_flush_coalesced_mmio_buffer();
+    } else if (tcg_enabled()) {
+        memory_region_flush_coalesced_tcg();
+    }
 }
 
 void qemu_mutex_lock_ramlist(void)
@@ -2139,7 +2192,8 @@ static void dirty_memory_extend(ram_addr_t new_ram_size)
         }
 
         for (j = old_num_blocks; j < new_num_blocks; j++) {
-            new_blocks->blocks[j] = bitmap_new(DIRTY_MEMORY_BLOCK_SIZE);
+            new_blocks->blocks[j] = bitmap_new(DIRTY_MEMORY_BLOCK_SIZE +
+                                               DIRTY_MEMORY_BLOCK_WORDS);
         }
 
         qatomic_rcu_set(&ram_list.dirty_memory[i], new_blocks);
@@ -3115,6 +3169,7 @@ static void memory_map_init(void)
     memory_region_init_io(system_io, NULL, &unassigned_io_ops, NULL, "io",
                           65536);
     address_space_init(&address_space_io, system_io, "I/O");
+    ioport_dispatch_init();
 }
 
 MemoryRegion *get_system_memory(void)
@@ -3463,6 +3518,104 @@ MemTxResult address_space_rw(AddressSpace *as, hwaddr addr, MemTxAttrs attrs,
     }
 }
 
+typedef struct AddressSpaceDMACache {
+    struct rcu_head rcu;
+    unsigned gen;
+    MemoryRegion *mr;
+    uint8_t *host;
+    /* The section covers [start, start + len) in the address space. */
+    hwaddr start;
+    hwaddr len;
+    hwaddr offset_within_region;
+    bool writable;
+} AddressSpaceDMACache;
+
+/* Called from RCU critical section */
+static AddressSpaceDMACache *address_space_dma_cache_fill(AddressSpace *as,
+                                                          hwaddr addr,
+                                                          hwaddr len)
+{
+    unsigned gen = qatomic_load_acquire(&as->dma_cache_gen);
+    FlatView *fv = address_space_to_flatview(as);
+    MemoryRegionSection *section;
+    AddressSpaceDMACache *c, *old;
+    MemoryRegion *mr;
+
+    if (xen_enabled()) {
+        return NULL;
+    }
+
+    /* IOMMUs and subpages are not RAM, so they are never cached. */
+    section = address_space_lookup_region(flatview_to_dispatch(fv), addr,
+                                          false);
+    mr = section->mr;
+    if (!memory_region_supports_direct_access(mr) ||
+        int128_gethi(section->size)) {
+        return NULL;
+    }
+    /* Do not evict the current entry for an access that spans sections. */
+    if (len > int128_get64(section->size) -
+              (addr - section->offset_within_address_space)) {
+        return NULL;
+    }
+
+    c = g_new(AddressSpaceDMACache, 1);
+    c->gen = gen;
+    c->mr = mr;
+    c->host = qemu_map_ram_ptr(mr->ram_block, section->offset_within_region);
+    c->start = section->offset_within_address_space;
+    c->len = int128_get64(section->size);
+    c->offset_within_region = section->offset_within_region;
+    c->writable = !mr->readonly && !mr->rom_device;
+
+    old = qatomic_xchg(&as->dma_cache, c);
+    if (old) {
+        g_free_rcu(old, rcu);
+    }
+    return c;
+}
+
+static bool address_space_dma_cache_hit(AddressSpaceDMACache *c,
+                                        AddressSpace *as, hwaddr addr,
+                                        hwaddr len, bool is_write,
+                                        MemTxAttrs attrs)
+{
+    return c && c->gen == qatomic_load_acquire(&as->dma_cache_gen) &&
+           addr - c->start < c->len && len <= c->len - (addr - c->start) &&
+           (!is_write || c->writable || attrs.debug);
+}
+
+MemTxResult address_space_dma_rw(AddressSpace *as, hwaddr addr,
+                                 MemTxAttrs attrs, void *buf,
+                                 hwaddr len, bool is_write)
+{
+    AddressSpaceDMACache *c;
+    hwaddr offset;
+
+    if (!len) {
+        return MEMTX_OK;
+    }
+
+    RCU_READ_LOCK_GUARD();
+    c = qatomic_rcu_read(&as->dma_cache);
+    if (!address_space_dma_cache_hit(c, as, addr, len, is_write, attrs)) {
+        c = address_space_dma_cache_fill(as, addr, len);
+        if (!address_space_dma_cache_hit(c, as, addr, len, is_write, attrs)) {
+            return address_space_rw(as, addr, attrs, buf, len, is_write);
+        }
+    }
+
+    offset = addr - c->start;
+    if (is_write) {
+        memcpy(c->host + offset, buf, len);
+        invalidate_and_set_dirty(c->mr, c->offset_within_region + offset, len);
+    } else {
+        fuzz_dma_read_cb(addr, len, c->mr);
+        memcpy(buf, c->host + offset, len);
+    }
+    return MEMTX_OK;
+}
+
 MemTxResult address_space_set(AddressSpace *as, hwaddr addr,
                               uint8_t c, hwaddr len, MemTxAttrs attrs)
 {
@@ -47,129 +47,6 @@
 #define LANE_WIDTH (SHIFT ? 16 : 8)
 #define PACK_WIDTH (LANE_WIDTH / 2)
 
-#if SHIFT == 0
-#define FPSRL(x, c) ((x) >> shift)
-#define FPSRAW(x, c) ((int16_t)(x) >> shift)
-#define FPSRAL(x, c) ((int32_t)(x) >> shift)
-#define FPSLL(x, c) ((x) << shift)
-#endif
-
-void glue(helper_psrlw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 15) {
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = 0;
-        }
-    } else {
-        shift = c->B(0);
-        for (int i = 0; i < 4 << SHIFT; i++) {
-            d->W(i) = FPSRL(s->W(i), shift);
-        }
-    }
-}
-
-void glue(helper_psllw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 15) {
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = 0;
-        }
-    } else {
-        shift = c->B(0);
-        for (int i = 0; i < 4 << SHIFT; i++) {
-            d->W(i) = FPSLL(s->W(i), shift);
-        }
-    }
-}
-
-void glue(helper_psraw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 15) {
-        shift = 15;
-    } else {
-        shift = c->B(0);
-    }
-    for (int i = 0; i < 4 << SHIFT; i++) {
-        d->W(i) = FPSRAW(s->W(i), shift);
-    }
-}
-
-void glue(helper_psrld, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 31) {
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = 0;
-        }
-    } else {
-        shift = c->B(0);
-        for (int i = 0; i < 2 << SHIFT; i++) {
-            d->L(i) = FPSRL(s->L(i), shift);
-        }
-    }
-}
-
-void glue(helper_pslld, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 31) {
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = 0;
-        }
-    } else {
-        shift = c->B(0);
-        for (int i = 0; i < 2 << SHIFT; i++) {
-            d->L(i) = FPSLL(s->L(i), shift);
-        }
-    }
-}
-
-void glue(helper_psrad, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 31) {
-        shift = 31;
-    } else {
-        shift = c->B(0);
-    }
-    for (int i = 0; i < 2 << SHIFT; i++) {
-        d->L(i) = FPSRAL(s->L(i), shift);
-    }
-}
-
-void glue(helper_psrlq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 63) {
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = 0;
-        }
-    } else {
-        shift = c->B(0);
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = FPSRL(s->Q(i), shift);
-        }
-    }
-}
-
-void glue(helper_psllq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
-{
-    int shift;
-    if (c->Q(0) > 63) {
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = 0;
-        }
-    } else {
-        shift = c->B(0);
-        for (int i = 0; i < 1 << SHIFT; i++) {
-            d->Q(i) = FPSLL(s->Q(i), shift);
-        }
-    }
-}
-
 #if SHIFT >= 1
 void glue(helper_psrldq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s, Reg *c)
 {
@@ -320,16 +197,6 @@ void glue(helper_pmulhrw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 #endif
 
 SSE_HELPER_B(helper_pavgb, FAVG)
-SSE_HELPER_W(helper_pavgw, FAVG)
-
-void glue(helper_pmuludq, SUFFIX)(CPUX86State *env, Reg *d, Reg *v, Reg *s)
-{
-    int i;
-
-    for (i = 0; i < (1 << SHIFT); i++) {
-        d->Q(i) = (uint64_t)s->L(i * 2) * (uint64_t)v->L(i * 2);
-    }
-}
 
 void glue(helper_pmaddwd, SUFFIX)(CPUX86State *env, Reg *d, Reg *v, Reg *s)
 {
@@ -1648,15 +1515,6 @@ SSE_HELPER_F(helper_pmovshdup, L, 2 << SHIFT, FMOVSHDUP)
 SSE_HELPER_F(helper_pmovdldup, Q, 1 << SHIFT, FMOVDLDUP)
 #endif
 
-void glue(helper_pmuldq, SUFFIX)(CPUX86State *env, Reg *d, Reg *v, Reg *s)
-{
-    int i;
-
-    for (i = 0; i < 1 << SHIFT; i++) {
-        d->Q(i) = (int64_t)(int32_t) v->L(2 * i) * (int32_t) s->L(2 * i);
-    }
-}
-
 void glue(helper_packusdw, SUFFIX)(CPUX86State *env, Reg *d, Reg *v, Reg *s)
 {
     uint16_t r[8];
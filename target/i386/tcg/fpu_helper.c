@@ -205,6 +205,22 @@ static inline int save_exception_flags(CPUX86State *env)
     return old_flags;
 }
 
+/*
+ * For arithmetic whose only interesting flags are the IEEE ones: if the
+ * guest already has a sticky precision exception, start out with inexact
+ * set.  Raising it again does not change FPUS, and it lets softfloat
+ * compute the result with the host FPU.
+ */
+static inline int save_exception_flags_arith(CPUX86State *env)
+{
+    int old_flags = save_exception_flags(env);
+
+    if (env->fpus & FPUS_PE) {
+        set_float_exception_flags(float_flag_inexact, &env->fp_status);
+    }
+    return old_flags;
+}
+
 static void merge_exception_flags(CPUX86State *env, int old_flags)
 {
     int new_flags = get_float_exception_flags(&env->fp_status);
@@ -220,7 +236,7 @@ static void merge_exception_flags(CPUX86State *env, int old_flags)
 
 static inline floatx80 helper_fdiv(CPUX86State *env, floatx80 a, floatx80 b)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     floatx80 ret = floatx80_div(a, b, &env->fp_status);
     merge_exception_flags(env, old_flags);
     return ret;
@@ -575,28 +591,28 @@ void helper_fucomi_ST0_FT0(CPUX86State *env)
 
 void helper_fadd_ST0_FT0(CPUX86State *env)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST0 = floatx80_add(ST0, FT0, &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
 
 void helper_fmul_ST0_FT0(CPUX86State *env)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST0 = floatx80_mul(ST0, FT0, &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
 
 void helper_fsub_ST0_FT0(CPUX86State *env)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST0 = floatx80_sub(ST0, FT0, &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
 
 void helper_fsubr_ST0_FT0(CPUX86State *env)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST0 = floatx80_sub(FT0, ST0, &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
@@ -615,28 +631,28 @@ void helper_fdivr_ST0_FT0(CPUX86State *env)
 
 void helper_fadd_STN_ST0(CPUX86State *env, int st_index)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST(st_index) = floatx80_add(ST(st_index), ST0, &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
 
 void helper_fmul_STN_ST0(CPUX86State *env, int st_index)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST(st_index) = floatx80_mul(ST(st_index), ST0, &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
 
 void helper_fsub_STN_ST0(CPUX86State *env, int st_index)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST(st_index) = floatx80_sub(ST(st_index), ST0, &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
 
 void helper_fsubr_STN_ST0(CPUX86State *env, int st_index)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     ST(st_index) = floatx80_sub(ST0, ST(st_index), &env->fp_status);
     merge_exception_flags(env, old_flags);
 }
@@ -2298,7 +2314,7 @@ void helper_fyl2x(CPUX86State *env)
 
 void helper_fsqrt(CPUX86State *env)
 {
-    int old_flags = save_exception_flags(env);
+    int old_flags = save_exception_flags_arith(env);
     if (floatx80_is_neg(ST0)) {
         env->fpus &= ~0x4700;  /* (C3,C2,C1,C0) <-- 0000 */
         env->fpus |= 0x400;
@@ -610,6 +610,33 @@ static bool get_physical_address(CPUX86State *env, vaddr addr,
     return true;
 }
 
+/*
+ * With paging disabled, linear addresses are identity mapped, so the
+ * RAM at address 0 (conventional memory, on a PC) can be published as
+ * the tlb direct window and read without TLB lookups.  Changes to CR0,
+ * A20 or the memory map flush the TLB and with it the window.  SMM is
+ * left alone, because entering and leaving it from real mode does not
+ * flush the TLB.
+ */
+static void x86_set_direct_window(CPUState *cs, CPUX86State *env)
+{
+    MemTxAttrs attrs = cpu_get_mem_attrs(env);
+    AddressSpace *as = cpu_get_address_space(cs, X86ASIdx_MEM);
+    MemoryRegion *mr;
+    hwaddr xlat;
+    hwaddr len = UINT32_MAX;
+
+    RCU_READ_LOCK_GUARD();
+    mr = address_space_translate(as, 0, &xlat, &len, false, attrs);
+    if (!memory_region_is_ram(mr) || memory_region_is_ram_device(mr)) {
+        return;
+    }
+    if (!(x86_get_a20_mask(env) & (1 << 20))) {
+        len = MIN(len, 1 << 20);
+    }
+    tlb_set_direct_window(cs, memory_region_get_ram_ptr(mr) + xlat, len);
+}
+
 bool x86_cpu_tlb_fill(CPUState *cs, vaddr addr, int size,
                       MMUAccessType access_type, int mmu_idx,
                       bool probe, uintptr_t retaddr)
@@ -629,6 +656,11 @@ bool x86_cpu_tlb_fill(CPUState *cs, vaddr addr, int size,
                                 out.paddr & TARGET_PAGE_MASK,
                                 cpu_get_mem_attrs(env),
                                 out.prot, mmu_idx, out.page_size);
+        if (!(env->cr[0] & CR0_PG_MASK) && mmu_idx < MMU_PHYS_IDX &&
+            !(env->hflags & HF_SMM_MASK) && !(env->hflags2 & HF2_NPT_MASK) &&
+            !cs->neg.tlb.direct.limit) {
+            x86_set_direct_window(cs, env);
+        }
         return true;
     }
 
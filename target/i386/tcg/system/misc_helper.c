@@ -23,6 +23,7 @@
 #include "exec/helper-proto.h"
 #include "accel/tcg/cpu-ldst.h"
 #include "system/address-spaces.h"
+#include "system/ioport.h"
 #include "system/memory.h"
 #include "exec/cputlb.h"
 #include "tcg/helper-tcg.h"
@@ -30,38 +31,62 @@
 
 void helper_outb(CPUX86State *env, uint32_t port, uint32_t data)
 {
-    address_space_stb(&address_space_io, port, data,
-                      cpu_get_mem_attrs(env), NULL);
+    MemTxAttrs attrs = cpu_get_mem_attrs(env);
+
+    if (!ioport_dispatch_write(port, MO_UB, data, attrs)) {
+        address_space_stb(&address_space_io, port, data, attrs, NULL);
+    }
 }
 
 target_ulong helper_inb(CPUX86State *env, uint32_t port)
 {
-    return address_space_ldub(&address_space_io, port,
-                              cpu_get_mem_attrs(env), NULL);
+    MemTxAttrs attrs = cpu_get_mem_attrs(env);
+    uint64_t val;
+
+    if (!ioport_dispatch_read(port, MO_UB, &val, attrs)) {
+        val = address_space_ldub(&address_space_io, port, attrs, NULL);
+    }
+    return val;
 }
 
 void helper_outw(CPUX86State *env, uint32_t port, uint32_t data)
 {
-    address_space_stw_le(&address_space_io, port, data,
-                         cpu_get_mem_attrs(env), NULL);
+    MemTxAttrs attrs = cpu_get_mem_attrs(env);
+
+    if (!ioport_dispatch_write(port, MO_LEUW, data, attrs)) {
+        address_space_stw_le(&address_space_io, port, data, attrs, NULL);
+    }
 }
 
 target_ulong helper_inw(CPUX86State *env, uint32_t port)
 {
-    return address_space_lduw_le(&address_space_io, port,
-                                 cpu_get_mem_attrs(env), NULL);
+    MemTxAttrs attrs = cpu_get_mem_attrs(env);
+    uint64_t val;
+
+    if (!ioport_dispatch_read(port, MO_LEUW, &val, attrs)) {
+        val = address_space_lduw_le(&address_space_io, port, attrs, NULL);
+    }
+    return val;
 }
 
 void helper_outl(CPUX86State *env, uint32_t port, uint32_t data)
 {
-    address_space_stl_le(&address_space_io, port, data,
-                         cpu_get_mem_attrs(env), NULL);
+    MemTxAttrs attrs = cpu_get_mem_attrs(env);
+
+    if (!ioport_dispatch_write(port, MO_LEUL, data, attrs)) {
+        address_space_stl_le(&address_space_io, port, data, attrs, NULL);
+    }
 }
 
 target_ulong helper_inl(CPUX86State *env, uint32_t port)
 {
-    return address_space_ldl_le(&address_space_io, port,
-                                cpu_get_mem_attrs(env), NULL);
+    MemTxAttrs attrs = cpu_get_mem_attrs(env);
+    uint64_t val;
+
+    if (!ioport_dispatch_read(port, MO_LEUL, &val, attrs)) {
+        val = address_space_ldl_le(&address_space_io, port, attrs, NULL);
+    }
+    return val;
 }
 
 target_ulong helper_read_cr8(CPUX86State *env)
@@ -101,6 +101,7 @@ typedef struct DisasContext {
 #ifndef CONFIG_USER_ONLY
     uint8_t cpl;   /* code priv level */
     uint8_t iopl;  /* i/o priv level */
+    bool direct_ram; /* try the tlb direct window for loads */
 #endif
     uint8_t vex_l;  /* vex vector length */
     uint8_t vex_v;  /* vex vvvv register, without 1's complement.  */
@@ -494,8 +495,84 @@ void gen_op_add_reg_im(DisasContext *s, MemOp size, int reg, int32_t val)
     gen_op_add_reg(s, size, reg, tcg_constant_tl(val));
 }
 
+#ifndef CONFIG_USER_ONLY
+#define TLB_DIRECT_OFS(field) \
+    ((int)(offsetof(CPUNegativeOffsetState, tlb.direct.field) - \
+           sizeof(CPUNegativeOffsetState)))
+
+/*
+ * Aligned loads below the limit of the tlb direct window, which
+ * x86_cpu_tlb_fill sets up while paging is disabled, are read straight
+ * from host memory.  Everything else goes through the softmmu TLB.
+ */
+static void gen_op_ld_direct(DisasContext *s, MemOp ot, TCGv t0, TCGv a0)
+{
+    MemOp size = ot & MO_SIZE;
+    TCGLabel *l_slow = gen_new_label();
+    TCGLabel *l_done = gen_new_label();
+    TCGv addr = tcg_temp_new();
+    TCGv limit = tcg_temp_new();
+    TCGv_ptr host = tcg_temp_new_ptr();
+    TCGv_ptr ptr = tcg_temp_new_ptr();
+
+    /*
+     * The limit is page aligned and below 4GiB.  Rotating the address
+     * moves any misaligned low bits to the top, failing the comparison.
+     */
+    tcg_gen_ld32u_tl(limit, tcg_env, TLB_DIRECT_OFS(limit));
+    tcg_gen_shri_tl(limit, limit, size);
+    tcg_gen_rotri_tl(addr, a0, size);
+    tcg_gen_brcond_tl(TCG_COND_GEU, addr, limit, l_slow);
+
+    tcg_gen_ld_ptr(host, tcg_env, TLB_DIRECT_OFS(host));
+#if TARGET_LONG_BITS == 64
+    tcg_gen_trunc_i64_ptr(ptr, a0);
+#else
+    tcg_gen_ext_i32_ptr(ptr, a0);
+#endif
+    tcg_gen_add_ptr(ptr, ptr, host);
+
+    /* Keep the load ordering that tcg_gen_qemu_ld would provide. */
+    tcg_gen_mb(TCG_MO_LD_LD | TCG_BAR_SC);
+    switch (ot & (MO_SIZE | MO_SIGN)) {
+    case MO_UB:
+        tcg_gen_ld8u_tl(t0, ptr, 0);
+        break;
+    case MO_SB:
+        tcg_gen_ld8s_tl(t0, ptr, 0);
+        break;
+    case MO_UW:
+        tcg_gen_ld16u_tl(t0, ptr, 0);
+        break;
+    case MO_SW:
+        tcg_gen_ld16s_tl(t0, ptr, 0);
+        break;
+    case MO_UL:
+        tcg_gen_ld32u_tl(t0, ptr, 0);
+        break;
+    case MO_SL:
+        tcg_gen_ld32s_tl(t0, ptr, 0);
+        break;
+    default:
+        g_assert_not_reached();
+    }
+    tcg_gen_br(l_done);
+
+    gen_set_label(l_slow);
+    tcg_gen_qemu_ld_tl(t0, a0, s->mem_index, ot | MO_LE);
+    gen_set_label(l_done);
+}
+#endif
+
 static inline void gen_op_ld_v(DisasContext *s, int idx, TCGv t0, TCGv a0)
 {
+#ifndef CONFIG_USER_ONLY
+    if (s->direct_ram && (idx & MO_SIZE) <= MO_32 &&
+        !s->base.plugin_enabled) {
+        gen_op_ld_direct(s, idx, t0, a0);
+        return;
+    }
+#endif
     tcg_gen_qemu_ld_tl(t0, a0, s->mem_index, idx | MO_LE);
 }
 
@@ -3479,6 +3556,15 @@ static void i386_tr_init_disas_context(DisasContextBase *dcbase, CPUState *cpu)
     dc->cpuid_xsave_features = env->features[FEAT_XSAVE];
     dc->jmp_opt = !((cflags & CF_NO_GOTO_TB) ||
                     (flags & (HF_RF_MASK | HF_TF_MASK | HF_INHIBIT_IRQ_MASK)));
+#ifndef CONFIG_USER_ONLY
+    /*
+     * CR0.PG is not part of the TB flags, but the window is empty while
+     * paging is enabled, so this only decides whether the check is worth
+     * emitting.  The host loads are little-endian.
+     */
+    dc->direct_ram = !HOST_BIG_ENDIAN && !(env->cr[0] & CR0_PG_MASK) &&
+                     !(flags & HF_SMM_MASK);
+#endif
 
     dc->T0 = tcg_temp_new();
     dc->T1 = tcg_temp_new();
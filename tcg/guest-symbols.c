@@ -0,0 +1,295 @@
+/*
+ * Guest symbol tables supplied by the user.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "qemu/osdep.h"
+#include "qapi/error.h"
+#include "qemu/bswap.h"
+#include "qemu/cutils.h"
+#include "qemu/rcu.h"
+#include "tcg/guest-symbols.h"
+
+typedef struct GuestSymbol {
+    uint64_t addr;
+    const char *name;
+} GuestSymbol;
+
+typedef struct GuestSymbolTable {
+    struct rcu_head rcu;
+    GStringChunk *names;
+    GArray *syms;
+} GuestSymbolTable;
+
+static GuestSymbolTable *guest_symbols;
+
+static void guest_symbols_add(GuestSymbolTable *t, uint64_t addr,
+                              const char *name, size_t len)
+{
+    GuestSymbol sym = {
+        .addr = addr,
+        .name = g_string_chunk_insert_len(t->names, name, len),
+    };
+
+    g_array_append_val(t->syms, sym);
+}
+
+/*
+ * Lines of nm(1) output are "<addr> <type> <name>", possibly followed
+ * by a module name.  Only keep code symbols; data symbols in between
+ * would otherwise steal samples from the function before them.
+ */
+static bool guest_symbols_parse_nm(GuestSymbolTable *t, char *text,
+                                   Error **errp)
+{
+    char *line, *next;
+
+    for (line = text; line && *line; line = next) {
+        uint64_t addr;
+        const char *p, *name;
+
+        next = strchr(line, '\n');
+        if (next) {
+            *next++ = '\0';
+        }
+        if (qemu_strtou64(line, &p, 16, &addr) < 0 || !qemu_isspace(*p)) {
+            continue;
+        }
+        while (qemu_isspace(*p)) {
+            p++;
+        }
+        if (p[0] && qemu_isspace(p[1])) {
+            if (!strchr("tTwW", p[0])) {
+                continue;
+            }
+            p += 2;
+            while (qemu_isspace(*p)) {
+                p++;
+            }
+        }
+        name = p;
+        while (*p && !qemu_isspace(*p)) {
+            p++;
+        }
+        if (p > name) {
+            guest_symbols_add(t, addr, name, p - name);
+        }
+    }
+
+    if (!t->syms->len) {
+        error_setg(errp, "no code symbols found");
+        return false;
+    }
+    return true;
+}
+
+/* Translate @rva to a file offset of @len bytes within a PE image. */
+static bool pe_rva_to_offset(const uint8_t *img, size_t size,
+                             size_t sections, unsigned nsections,
+                             uint32_t rva, size_t len, size_t *off)
+{
+    for (unsigned i = 0; i < nsections; i++) {
+        const uint8_t *sh = img + sections + i * 40;
+        uint32_t vsize = ldl_le_p(sh + 8);
+        uint32_t va = ldl_le_p(sh + 12);
+        uint32_t rawsize = ldl_le_p(sh + 16);
+        uint32_t raw = ldl_le_p(sh + 20);
+
+        if (rva >= va && rva - va < MAX(vsize, rawsize)) {
+            uint64_t o = (uint64_t)raw + (rva - va);
+
+            if (o + len > size) {
+                return false;
+            }
+            *off = o;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool guest_symbols_parse_pe(GuestSymbolTable *t, const uint8_t *img,
+                                   size_t size, uint64_t base, Error **errp)
+{
+    size_t pe, opt, sections, dir, names, ords, funcs;
+    unsigned nsections, ndirs;
+    uint32_t exp_rva, exp_size, nnames, nfuncs;
+    uint16_t magic;
+
+    if (size < 0x40) {
+        goto bad;
+    }
+    pe = ldl_le_p(img + 0x3c);
+    if (pe > size - 24 || memcmp(img + pe, "PE\0\0", 4)) {
+        goto bad;
+    }
+    nsections = lduw_le_p(img + pe + 6);
+    opt = pe + 24;
+    sections = opt + lduw_le_p(img + pe + 20);
+    if (sections + nsections * 40 > size || opt + 2 > size) {
+        goto bad;
+    }
+
+    magic = lduw_le_p(img + opt);
+    if (magic == 0x10b && opt + 96 <= sections) {
+        base = base ? : ldl_le_p(img + opt + 28);
+        ndirs = ldl_le_p(img + opt + 92);
+        dir = opt + 96;
+    } else if (magic == 0x20b && opt + 112 <= sections) {
+        base = base ? : ldq_le_p(img + opt + 24);
+        ndirs = ldl_le_p(img + opt + 108);
+        dir = opt + 112;
+    } else {
+        goto bad;
+    }
+    if (ndirs < 1 || dir + 8 > sections) {
+        error_setg(errp, "PE image has no export table");
+        return false;
+    }
+
+    exp_rva = ldl_le_p(img + dir);
+    exp_size = ldl_le_p(img + dir + 4);
+    if (!exp_rva ||
+        !pe_rva_to_offset(img, size, sections, nsections, exp_rva, 40, &dir)) {
+        error_setg(errp, "PE image has no export table");
+        return false;
+    }
+
+    nfuncs = ldl_le_p(img + dir + 20);
+    nnames = ldl_le_p(img + dir + 24);
+    if (!pe_rva_to_offset(img, size, sections, nsections,
+                          ldl_le_p(img + dir + 28), nfuncs * 4ull, &funcs) ||
+        !pe_rva_to_offset(img, size, sections, nsections,
+                          ldl_le_p(img + dir + 32), nnames * 4ull, &names) ||
+        !pe_rva_to_offset(img, size, sections, nsections,
+                          ldl_le_p(img + dir + 36), nnames * 2ull, &ords)) {
+        goto bad;
+    }
+
+    for (uint32_t i = 0; i < nnames; i++) {
+        uint16_t ord = lduw_le_p(img + ords + i * 2);
+        uint32_t rva;
+        size_t name;
+        const uint8_t *end;
+
+        if (ord >= nfuncs) {
+            continue;
+        }
+        rva = ldl_le_p(img + funcs + ord * 4);
+        /* Forwarders point back into the export table itself. */
+        if (rva - exp_rva < exp_size) {
+            continue;
+        }
+        if (!pe_rva_to_offset(img, size, sections, nsections,
+                              ldl_le_p(img + names + i * 4), 1, &name)) {
+            continue;
+        }
+        end = memchr(img + name, '\0', size - name);
+        if (end) {
+            guest_symbols_add(t, base + rva, (const char *)img + name,
+                              end - (img + name));
+        }
+    }
+
+    if (!t->syms->len) {
+        error_setg(errp, "PE image exports no named functions");
+        return false;
+    }
+    return true;
+
+ bad:
+    error_setg(errp, "malformed PE image");
+    return false;
+}
+
+static gint guest_symbol_cmp(gconstpointer a, gconstpointer b)
+{
+    const GuestSymbol *sa = a, *sb = b;
+
+    return sa->addr < sb->addr ? -1 : sa->addr > sb->addr;
+}
+
+static void guest_symbols_free(GuestSymbolTable *t)
+{
+    g_string_chunk_free(t->names);
+    g_array_free(t->syms, true);
+    g_free(t);
+}
+
+static void guest_symbols_replace(GuestSymbolTable *t)
+{
+    GuestSymbolTable *old = qatomic_xchg(&guest_symbols, t);
+
+    if (old) {
+        call_rcu(old, guest_symbols_free, rcu);
+    }
+}
+
+bool guest_symbols_load(const char *path, uint64_t base, Error **errp)
+{
+    g_autoptr(GError) gerr = NULL;
+    g_autofree char *text = NULL;
+    GuestSymbolTable *t;
+    gsize size;
+    bool ok;
+
+    if (!g_file_get_contents(path, &text, &size, &gerr)) {
+        error_setg(errp, "could not read '%s': %s", path, gerr->message);
+        return false;
+    }
+
+    t = g_new0(GuestSymbolTable, 1);
+    t->names = g_string_chunk_new(4096);
+    t->syms = g_array_new(false, false, sizeof(GuestSymbol));
+
+    if (size >= 2 && text[0] == 'M' && text[1] == 'Z') {
+        ok = guest_symbols_parse_pe(t, (const uint8_t *)text, size, base, errp);
+    } else {
+        ok = guest_symbols_parse_nm(t, text, errp);
+    }
+    if (!ok) {
+        error_prepend(errp, "%s: ", path);
+        guest_symbols_free(t);
+        return false;
+    }
+
+    g_array_sort(t->syms, guest_symbol_cmp);
+    guest_symbols_replace(t);
+    return true;
+}
+
+void guest_symbols_clear(void)
+{
+    guest_symbols_replace(NULL);
+}
+
+const char *guest_symbols_lookup(uint64_t addr, uint64_t *offset)
+{
+    GuestSymbolTable *t = qatomic_rcu_read(&guest_symbols);
+    const GuestSymbol *syms;
+    size_t lo = 0, hi;
+
+    if (!t || !t->syms->len) {
+        return NULL;
+    }
+
+    /* Find the last symbol whose address is <= @addr. */
+    syms = &g_array_index(t->syms, GuestSymbol, 0);
+    hi = t->syms->len;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+
+        if (syms[mid].addr <= addr) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return NULL;
+    }
+
+    *offset = addr - syms[lo - 1].addr;
+    return syms[lo - 1].name;
+}
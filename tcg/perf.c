@@ -12,8 +12,10 @@
 #include "elf.h"
 #include "exec/target_page.h"
 #include "exec/translation-block.h"
+#include "qemu/rcu.h"
 #include "qemu/timer.h"
 #include "tcg/debuginfo.h"
+#include "tcg/guest-symbols.h"
 #include "tcg/perf.h"
 #include "tcg/tcg.h"
 
@@ -340,6 +342,15 @@ void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
     }
     debuginfo_query(q, tb->icount);
 
+    /* Fall back to the symbols loaded by the user; see x-tcg-profile-start. */
+    rcu_read_lock();
+    for (insn = 0; insn < tb->icount; insn++) {
+        if (!q[insn].symbol) {
+            q[insn].symbol = guest_symbols_lookup(q[insn].address,
+                                                  &q[insn].offset);
+        }
+    }
+
     /* Emit perfmap entries if needed. */
     if (perfmap) {
         flockfile(perfmap);
@@ -358,6 +369,7 @@ void perf_report_code(uint64_t guest_pc, TranslationBlock *tb,
         funlockfile(jitdump);
     }
 
+    rcu_read_unlock();
     debuginfo_unlock();
     g_free(q);
 }
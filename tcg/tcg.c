@@ -6589,6 +6589,7 @@ int tcg_gen_code(TCGContext *s, TranslationBlock *tb, uint64_t pc_start)
     /* Do not reuse any EBB that may be allocated within the TB. */
     tcg_temp_ebb_reset_freed(s);
 
+    s->nb_ops_before_opt = s->nb_ops;
     tcg_optimize(s);
 
     reachable_code_pass(s);
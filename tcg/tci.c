@@ -79,6 +79,21 @@ static void tci_args_rl(uint32_t insn, const void *tb_ptr,
     *l1 = sextract32(insn, 12, 20) + (void *)tb_ptr;
 }
 
+/*
+ * The fused compare-and-branch insns carry a full 32-bit displacement
+ * in a second word, relative to the end of the insn.
+ */
+static void tci_args_rrcl(uint32_t insn, const uint32_t **tb_ptr,
+                          TCGReg *r0, TCGReg *r1, TCGCond *c2, void **l3)
+{
+    int32_t diff = *(*tb_ptr)++;
+
+    *r0 = extract32(insn, 8, 4);
+    *r1 = extract32(insn, 12, 4);
+    *c2 = extract32(insn, 16, 4);
+    *l3 = (void *)*tb_ptr + diff;
+}
+
 static void tci_args_rr(uint32_t insn, TCGReg *r0, TCGReg *r1)
 {
     *r0 = extract32(insn, 8, 4);
@@ -307,6 +322,31 @@ static void tci_qemu_st(CPUArchState *env, uint64_t taddr, uint64_t val,
     }
 }
 
+/*
+ * Outside of Emscripten, dispatch through a table of label addresses
+ * ("computed goto") rather than through the switch statement.  Each
+ * handler then ends with its own indirect jump to the next handler,
+ * which removes the range check and the shared jump at the top of the
+ * switch and gives the host branch predictor one prediction site per
+ * opcode instead of one for the whole interpreter.
+ */
+#ifndef EMSCRIPTEN
+# define TCI_THREADED
+#endif
+
+#ifdef TCI_THREADED
+# define CASE(name)  case INDEX_op_##name: op_##name
+# define TCI_NEXT()                         \
+    do {                                    \
+        insn = *tb_ptr++;                   \
+        opc = extract32(insn, 0, 8);        \
+        goto *dispatch[opc];                \
+    } while (0)
+#else
+# define CASE(name)  case INDEX_op_##name
+# define TCI_NEXT()  continue
+#endif
+
 /* Interpret pseudo code in tb. */
 /*
  * Disable CFI checks.
@@ -321,6 +361,91 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
     uint64_t stack[(TCG_STATIC_CALL_ARGS_SIZE + TCG_STATIC_FRAME_SIZE)
                    / sizeof(uint64_t)];
     bool carry = false;
+#ifdef TCI_THREADED
+    static const void * const dispatch[NB_OPS] = {
+        [0 ... NB_OPS - 1] = &&op_illegal,
+        [INDEX_op_call] = &&op_call,
+        [INDEX_op_br] = &&op_br,
+        [INDEX_op_setcond] = &&op_setcond,
+        [INDEX_op_movcond] = &&op_movcond,
+        [INDEX_op_mov] = &&op_mov,
+        [INDEX_op_tci_movi] = &&op_tci_movi,
+        [INDEX_op_tci_movl] = &&op_tci_movl,
+        [INDEX_op_tci_setcarry] = &&op_tci_setcarry,
+        [INDEX_op_ld8u] = &&op_ld8u,
+        [INDEX_op_ld8s] = &&op_ld8s,
+        [INDEX_op_ld16u] = &&op_ld16u,
+        [INDEX_op_ld16s] = &&op_ld16s,
+        [INDEX_op_ld] = &&op_ld,
+        [INDEX_op_st8] = &&op_st8,
+        [INDEX_op_st16] = &&op_st16,
+        [INDEX_op_st] = &&op_st,
+        [INDEX_op_add] = &&op_add,
+        [INDEX_op_sub] = &&op_sub,
+        [INDEX_op_mul] = &&op_mul,
+        [INDEX_op_and] = &&op_and,
+        [INDEX_op_or] = &&op_or,
+        [INDEX_op_xor] = &&op_xor,
+        [INDEX_op_andc] = &&op_andc,
+        [INDEX_op_orc] = &&op_orc,
+        [INDEX_op_eqv] = &&op_eqv,
+        [INDEX_op_nand] = &&op_nand,
+        [INDEX_op_nor] = &&op_nor,
+        [INDEX_op_neg] = &&op_neg,
+        [INDEX_op_not] = &&op_not,
+        [INDEX_op_ctpop] = &&op_ctpop,
+        [INDEX_op_addco] = &&op_addco,
+        [INDEX_op_addci] = &&op_addci,
+        [INDEX_op_addcio] = &&op_addcio,
+        [INDEX_op_subbo] = &&op_subbo,
+        [INDEX_op_subbi] = &&op_subbi,
+        [INDEX_op_subbio] = &&op_subbio,
+        [INDEX_op_muls2] = &&op_muls2,
+        [INDEX_op_mulu2] = &&op_mulu2,
+        [INDEX_op_tci_divs32] = &&op_tci_divs32,
+        [INDEX_op_tci_divu32] = &&op_tci_divu32,
+        [INDEX_op_tci_rems32] = &&op_tci_rems32,
+        [INDEX_op_tci_remu32] = &&op_tci_remu32,
+        [INDEX_op_tci_clz32] = &&op_tci_clz32,
+        [INDEX_op_tci_ctz32] = &&op_tci_ctz32,
+        [INDEX_op_tci_setcond32] = &&op_tci_setcond32,
+        [INDEX_op_tci_movcond32] = &&op_tci_movcond32,
+        [INDEX_op_shl] = &&op_shl,
+        [INDEX_op_shr] = &&op_shr,
+        [INDEX_op_sar] = &&op_sar,
+        [INDEX_op_tci_rotl32] = &&op_tci_rotl32,
+        [INDEX_op_tci_rotr32] = &&op_tci_rotr32,
+        [INDEX_op_deposit] = &&op_deposit,
+        [INDEX_op_extract] = &&op_extract,
+        [INDEX_op_sextract] = &&op_sextract,
+        [INDEX_op_tci_brcond] = &&op_tci_brcond,
+        [INDEX_op_tci_brcond32] = &&op_tci_brcond32,
+        [INDEX_op_bswap16] = &&op_bswap16,
+        [INDEX_op_bswap32] = &&op_bswap32,
+        [INDEX_op_ld32u] = &&op_ld32u,
+        [INDEX_op_ld32s] = &&op_ld32s,
+        [INDEX_op_st32] = &&op_st32,
+        [INDEX_op_divs] = &&op_divs,
+        [INDEX_op_divu] = &&op_divu,
+        [INDEX_op_rems] = &&op_rems,
+        [INDEX_op_remu] = &&op_remu,
+        [INDEX_op_clz] = &&op_clz,
+        [INDEX_op_ctz] = &&op_ctz,
+        [INDEX_op_rotl] = &&op_rotl,
+        [INDEX_op_rotr] = &&op_rotr,
+        [INDEX_op_ext_i32_i64] = &&op_ext_i32_i64,
+        [INDEX_op_extu_i32_i64] = &&op_extu_i32_i64,
+        [INDEX_op_bswap64] = &&op_bswap64,
+        [INDEX_op_exit_tb] = &&op_exit_tb,
+        [INDEX_op_goto_tb] = &&op_goto_tb,
+        [INDEX_op_goto_ptr] = &&op_goto_ptr,
+        [INDEX_op_qemu_ld] = &&op_qemu_ld,
+        [INDEX_op_tci_qemu_ld_rrr] = &&op_tci_qemu_ld_rrr,
+        [INDEX_op_qemu_st] = &&op_qemu_st,
+        [INDEX_op_tci_qemu_st_rrr] = &&op_tci_qemu_st_rrr,
+        [INDEX_op_mb] = &&op_mb,
+    };
+#endif
 
     regs[TCG_AREG0] = (tcg_target_ulong)env;
     regs[TCG_REG_CALL_STACK] = (uintptr_t)stack;
@@ -343,7 +468,7 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
         opc = extract32(insn, 0, 8);
 
         switch (opc) {
-        case INDEX_op_call:
+        CASE(call):
             {
                 void *call_slots[MAX_CALL_IARGS];
                 ffi_cif *cif;
@@ -390,149 +515,149 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
             default:
                 g_assert_not_reached();
             }
-            break;
+            TCI_NEXT();
 
-        case INDEX_op_br:
+        CASE(br):
             tci_args_l(insn, tb_ptr, &ptr);
             tb_ptr = ptr;
-            continue;
-        case INDEX_op_setcond:
+            TCI_NEXT();
+        CASE(setcond):
             tci_args_rrrc(insn, &r0, &r1, &r2, &condition);
             regs[r0] = tci_compare64(regs[r1], regs[r2], condition);
-            break;
-        case INDEX_op_movcond:
+            TCI_NEXT();
+        CASE(movcond):
             tci_args_rrrrrc(insn, &r0, &r1, &r2, &r3, &r4, &condition);
             tmp32 = tci_compare64(regs[r1], regs[r2], condition);
             regs[r0] = regs[tmp32 ? r3 : r4];
-            break;
-        case INDEX_op_mov:
+            TCI_NEXT();
+        CASE(mov):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = regs[r1];
-            break;
-        case INDEX_op_tci_movi:
+            TCI_NEXT();
+        CASE(tci_movi):
             tci_args_ri(insn, &r0, &t1);
             regs[r0] = t1;
-            break;
-        case INDEX_op_tci_movl:
+            TCI_NEXT();
+        CASE(tci_movl):
             tci_args_rl(insn, tb_ptr, &r0, &ptr);
             regs[r0] = *(tcg_target_ulong *)ptr;
-            break;
-        case INDEX_op_tci_setcarry:
+            TCI_NEXT();
+        CASE(tci_setcarry):
             carry = true;
-            break;
+            TCI_NEXT();
 
             /* Load/store operations (32 bit). */
 
-        case INDEX_op_ld8u:
+        CASE(ld8u):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(uint8_t *)ptr;
-            break;
-        case INDEX_op_ld8s:
+            TCI_NEXT();
+        CASE(ld8s):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(int8_t *)ptr;
-            break;
-        case INDEX_op_ld16u:
+            TCI_NEXT();
+        CASE(ld16u):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(uint16_t *)ptr;
-            break;
-        case INDEX_op_ld16s:
+            TCI_NEXT();
+        CASE(ld16s):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(int16_t *)ptr;
-            break;
-        case INDEX_op_ld:
+            TCI_NEXT();
+        CASE(ld):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(tcg_target_ulong *)ptr;
-            break;
-        case INDEX_op_st8:
+            TCI_NEXT();
+        CASE(st8):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(uint8_t *)ptr = regs[r0];
-            break;
-        case INDEX_op_st16:
+            TCI_NEXT();
+        CASE(st16):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(uint16_t *)ptr = regs[r0];
-            break;
-        case INDEX_op_st:
+            TCI_NEXT();
+        CASE(st):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(tcg_target_ulong *)ptr = regs[r0];
-            break;
+            TCI_NEXT();
 
             /* Arithmetic operations (mixed 32/64 bit). */
 
-        case INDEX_op_add:
+        CASE(add):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] + regs[r2];
-            break;
-        case INDEX_op_sub:
+            TCI_NEXT();
+        CASE(sub):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] - regs[r2];
-            break;
-        case INDEX_op_mul:
+            TCI_NEXT();
+        CASE(mul):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] * regs[r2];
-            break;
-        case INDEX_op_and:
+            TCI_NEXT();
+        CASE(and):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] & regs[r2];
-            break;
-        case INDEX_op_or:
+            TCI_NEXT();
+        CASE(or):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] | regs[r2];
-            break;
-        case INDEX_op_xor:
+            TCI_NEXT();
+        CASE(xor):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] ^ regs[r2];
-            break;
-        case INDEX_op_andc:
+            TCI_NEXT();
+        CASE(andc):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] & ~regs[r2];
-            break;
-        case INDEX_op_orc:
+            TCI_NEXT();
+        CASE(orc):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] | ~regs[r2];
-            break;
-        case INDEX_op_eqv:
+            TCI_NEXT();
+        CASE(eqv):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = ~(regs[r1] ^ regs[r2]);
-            break;
-        case INDEX_op_nand:
+            TCI_NEXT();
+        CASE(nand):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = ~(regs[r1] & regs[r2]);
-            break;
-        case INDEX_op_nor:
+            TCI_NEXT();
+        CASE(nor):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = ~(regs[r1] | regs[r2]);
-            break;
-        case INDEX_op_neg:
+            TCI_NEXT();
+        CASE(neg):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = -regs[r1];
-            break;
-        case INDEX_op_not:
+            TCI_NEXT();
+        CASE(not):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = ~regs[r1];
-            break;
-        case INDEX_op_ctpop:
+            TCI_NEXT();
+        CASE(ctpop):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = ctpop64(regs[r1]);
-            break;
-        case INDEX_op_addco:
+            TCI_NEXT();
+        CASE(addco):
             tci_args_rrr(insn, &r0, &r1, &r2);
             t1 = regs[r1] + regs[r2];
             carry = t1 < regs[r1];
             regs[r0] = t1;
-            break;
-        case INDEX_op_addci:
+            TCI_NEXT();
+        CASE(addci):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] + regs[r2] + carry;
-            break;
-        case INDEX_op_addcio:
+            TCI_NEXT();
+        CASE(addcio):
             tci_args_rrr(insn, &r0, &r1, &r2);
             if (carry) {
                 t1 = regs[r1] + regs[r2] + 1;
@@ -542,17 +667,17 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
                 carry = t1 < regs[r1];
             }
             regs[r0] = t1;
-            break;
-        case INDEX_op_subbo:
+            TCI_NEXT();
+        CASE(subbo):
             tci_args_rrr(insn, &r0, &r1, &r2);
             carry = regs[r1] < regs[r2];
             regs[r0] = regs[r1] - regs[r2];
-            break;
-        case INDEX_op_subbi:
+            TCI_NEXT();
+        CASE(subbi):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] - regs[r2] - carry;
-            break;
-        case INDEX_op_subbio:
+            TCI_NEXT();
+        CASE(subbio):
             tci_args_rrr(insn, &r0, &r1, &r2);
             if (carry) {
                 carry = regs[r1] <= regs[r2];
@@ -561,226 +686,238 @@ uintptr_t QEMU_DISABLE_CFI tcg_qemu_tb_exec(CPUArchState *env,
                 carry = regs[r1] < regs[r2];
                 regs[r0] = regs[r1] - regs[r2];
             }
-            break;
-        case INDEX_op_muls2:
+            TCI_NEXT();
+        CASE(muls2):
             tci_args_rrrr(insn, &r0, &r1, &r2, &r3);
             muls64(&regs[r0], &regs[r1], regs[r2], regs[r3]);
-            break;
-        case INDEX_op_mulu2:
+            TCI_NEXT();
+        CASE(mulu2):
             tci_args_rrrr(insn, &r0, &r1, &r2, &r3);
             mulu64(&regs[r0], &regs[r1], regs[r2], regs[r3]);
-            break;
+            TCI_NEXT();
 
             /* Arithmetic operations (32 bit). */
 
-        case INDEX_op_tci_divs32:
+        CASE(tci_divs32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (int32_t)regs[r1] / (int32_t)regs[r2];
-            break;
-        case INDEX_op_tci_divu32:
+            TCI_NEXT();
+        CASE(tci_divu32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (uint32_t)regs[r1] / (uint32_t)regs[r2];
-            break;
-        case INDEX_op_tci_rems32:
+            TCI_NEXT();
+        CASE(tci_rems32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (int32_t)regs[r1] % (int32_t)regs[r2];
-            break;
-        case INDEX_op_tci_remu32:
+            TCI_NEXT();
+        CASE(tci_remu32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (uint32_t)regs[r1] % (uint32_t)regs[r2];
-            break;
-        case INDEX_op_tci_clz32:
+            TCI_NEXT();
+        CASE(tci_clz32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             tmp32 = regs[r1];
             regs[r0] = tmp32 ? clz32(tmp32) : regs[r2];
-            break;
-        case INDEX_op_tci_ctz32:
+            TCI_NEXT();
+        CASE(tci_ctz32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             tmp32 = regs[r1];
             regs[r0] = tmp32 ? ctz32(tmp32) : regs[r2];
-            break;
-        case INDEX_op_tci_setcond32:
+            TCI_NEXT();
+        CASE(tci_setcond32):
             tci_args_rrrc(insn, &r0, &r1, &r2, &condition);
             regs[r0] = tci_compare32(regs[r1], regs[r2], condition);
-            break;
-        case INDEX_op_tci_movcond32:
+            TCI_NEXT();
+        CASE(tci_movcond32):
             tci_args_rrrrrc(insn, &r0, &r1, &r2, &r3, &r4, &condition);
             tmp32 = tci_compare32(regs[r1], regs[r2], condition);
             regs[r0] = regs[tmp32 ? r3 : r4];
-            break;
+            TCI_NEXT();
 
             /* Shift/rotate operations. */
 
-        case INDEX_op_shl:
+        CASE(shl):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] << (regs[r2] % TCG_TARGET_REG_BITS);
-            break;
-        case INDEX_op_shr:
+            TCI_NEXT();
+        CASE(shr):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] >> (regs[r2] % TCG_TARGET_REG_BITS);
-            break;
-        case INDEX_op_sar:
+            TCI_NEXT();
+        CASE(sar):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = ((tcg_target_long)regs[r1]
                         >> (regs[r2] % TCG_TARGET_REG_BITS));
-            break;
-        case INDEX_op_tci_rotl32:
+            TCI_NEXT();
+        CASE(tci_rotl32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = rol32(regs[r1], regs[r2] & 31);
-            break;
-        case INDEX_op_tci_rotr32:
+            TCI_NEXT();
+        CASE(tci_rotr32):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = ror32(regs[r1], regs[r2] & 31);
-            break;
-        case INDEX_op_deposit:
+            TCI_NEXT();
+        CASE(deposit):
             tci_args_rrrbb(insn, &r0, &r1, &r2, &pos, &len);
             regs[r0] = deposit64(regs[r1], pos, len, regs[r2]);
-            break;
-        case INDEX_op_extract:
+            TCI_NEXT();
+        CASE(extract):
             tci_args_rrbb(insn, &r0, &r1, &pos, &len);
             regs[r0] = extract64(regs[r1], pos, len);
-            break;
-        case INDEX_op_sextract:
+            TCI_NEXT();
+        CASE(sextract):
             tci_args_rrbb(insn, &r0, &r1, &pos, &len);
             regs[r0] = sextract64(regs[r1], pos, len);
-            break;
-        case INDEX_op_brcond:
-            tci_args_rl(insn, tb_ptr, &r0, &ptr);
-            if (regs[r0]) {
+            TCI_NEXT();
+        CASE(tci_brcond):
+            tci_args_rrcl(insn, &tb_ptr, &r0, &r1, &condition, &ptr);
+            if (tci_compare64(regs[r0], regs[r1], condition)) {
                 tb_ptr = ptr;
             }
-            break;
-        case INDEX_op_bswap16:
+            TCI_NEXT();
+        CASE(tci_brcond32):
+            tci_args_rrcl(insn, &tb_ptr, &r0, &r1, &condition, &ptr);
+            if (tci_compare32(regs[r0], regs[r1], condition)) {
+                tb_ptr = ptr;
+            }
+            TCI_NEXT();
+        CASE(bswap16):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = bswap16(regs[r1]);
-            break;
-        case INDEX_op_bswap32:
+            TCI_NEXT();
+        CASE(bswap32):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = bswap32(regs[r1]);
-            break;
+            TCI_NEXT();
 
             /* Load/store operations (64 bit). */
 
-        case INDEX_op_ld32u:
+        CASE(ld32u):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(uint32_t *)ptr;
-            break;
-        case INDEX_op_ld32s:
+            TCI_NEXT();
+        CASE(ld32s):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             regs[r0] = *(int32_t *)ptr;
-            break;
-        case INDEX_op_st32:
+            TCI_NEXT();
+        CASE(st32):
             tci_args_rrs(insn, &r0, &r1, &ofs);
             ptr = (void *)(regs[r1] + ofs);
             *(uint32_t *)ptr = regs[r0];
-            break;
+            TCI_NEXT();
 
             /* Arithmetic operations (64 bit). */
 
-        case INDEX_op_divs:
+        CASE(divs):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (int64_t)regs[r1] / (int64_t)regs[r2];
-            break;
-        case INDEX_op_divu:
+            TCI_NEXT();
+        CASE(divu):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (uint64_t)regs[r1] / (uint64_t)regs[r2];
-            break;
-        case INDEX_op_rems:
+            TCI_NEXT();
+        CASE(rems):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (int64_t)regs[r1] % (int64_t)regs[r2];
-            break;
-        case INDEX_op_remu:
+            TCI_NEXT();
+        CASE(remu):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = (uint64_t)regs[r1] % (uint64_t)regs[r2];
-            break;
-        case INDEX_op_clz:
+            TCI_NEXT();
+        CASE(clz):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] ? clz64(regs[r1]) : regs[r2];
-            break;
-        case INDEX_op_ctz:
+            TCI_NEXT();
+        CASE(ctz):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = regs[r1] ? ctz64(regs[r1]) : regs[r2];
-            break;
+            TCI_NEXT();
 
             /* Shift/rotate operations (64 bit). */
 
-        case INDEX_op_rotl:
+        CASE(rotl):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = rol64(regs[r1], regs[r2] & 63);
-            break;
-        case INDEX_op_rotr:
+            TCI_NEXT();
+        CASE(rotr):
             tci_args_rrr(insn, &r0, &r1, &r2);
             regs[r0] = ror64(regs[r1], regs[r2] & 63);
-            break;
-        case INDEX_op_ext_i32_i64:
+            TCI_NEXT();
+        CASE(ext_i32_i64):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = (int32_t)regs[r1];
-            break;
-        case INDEX_op_extu_i32_i64:
+            TCI_NEXT();
+        CASE(extu_i32_i64):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = (uint32_t)regs[r1];
-            break;
-        case INDEX_op_bswap64:
+            TCI_NEXT();
+        CASE(bswap64):
             tci_args_rr(insn, &r0, &r1);
             regs[r0] = bswap64(regs[r1]);
-            break;
+            TCI_NEXT();
 
             /* QEMU specific operations. */
 
-        case INDEX_op_exit_tb:
+        CASE(exit_tb):
             tci_args_l(insn, tb_ptr, &ptr);
             return (uintptr_t)ptr;
 
-        case INDEX_op_goto_tb:
+        CASE(goto_tb):
             tci_args_l(insn, tb_ptr, &ptr);
             tb_ptr = *(void **)ptr;
-            break;
+            TCI_NEXT();
 
-        case INDEX_op_goto_ptr:
+        CASE(goto_ptr):
             tci_args_r(insn, &r0);
             ptr = (void *)regs[r0];
             if (!ptr) {
                 return 0;
             }
             tb_ptr = ptr;
-            break;
+            TCI_NEXT();
 
-        case INDEX_op_qemu_ld:
+        CASE(qemu_ld):
             tci_args_rrm(insn, &r0, &r1, &oi);
             taddr = regs[r1];
             regs[r0] = tci_qemu_ld(env, taddr, oi, tb_ptr);
-            break;
-        case INDEX_op_tci_qemu_ld_rrr:
+            TCI_NEXT();
+        CASE(tci_qemu_ld_rrr):
             tci_args_rrr(insn, &r0, &r1, &r2);
             taddr = regs[r1];
             oi = regs[r2];
             regs[r0] = tci_qemu_ld(env, taddr, oi, tb_ptr);
-            break;
+            TCI_NEXT();
 
-        case INDEX_op_qemu_st:
+        CASE(qemu_st):
             tci_args_rrm(insn, &r0, &r1, &oi);
             taddr = regs[r1];
             tci_qemu_st(env, taddr, regs[r0], oi, tb_ptr);
-            break;
-        case INDEX_op_tci_qemu_st_rrr:
+            TCI_NEXT();
+        CASE(tci_qemu_st_rrr):
             tci_args_rrr(insn, &r0, &r1, &r2);
             taddr = regs[r1];
             oi = regs[r2];
             tci_qemu_st(env, taddr, regs[r0], oi, tb_ptr);
-            break;
+            TCI_NEXT();
 
-        case INDEX_op_mb:
+        CASE(mb):
             /* Ensure ordering for all kinds */
             smp_mb();
-            break;
+            TCI_NEXT();
         default:
+#ifdef TCI_THREADED
+        op_illegal:
+#endif
             g_assert_not_reached();
         }
     }
 }
 
+#undef CASE
+#undef TCI_NEXT
+
 /*
  * Disassembler that matches the interpreter
  */
@@ -866,11 +1003,12 @@ int print_insn_tci(bfd_vma addr, disassemble_info *info)
         info->fprintf_func(info->stream, "%-12s  %d, %p", op_name, len, ptr);
         break;
 
-    case INDEX_op_brcond:
-        tci_args_rl(insn, tb_ptr, &r0, &ptr);
-        info->fprintf_func(info->stream, "%-12s  %s, 0, ne, %p",
-                           op_name, str_r(r0), ptr);
-        break;
+    case INDEX_op_tci_brcond:
+    case INDEX_op_tci_brcond32:
+        tci_args_rrcl(insn, &tb_ptr, &r0, &r1, &c, &ptr);
+        info->fprintf_func(info->stream, "%-12s  %s, %s, %s, %p",
+                           op_name, str_r(r0), str_r(r1), str_c(c), ptr);
+        return 2 * sizeof(insn);
 
     case INDEX_op_setcond:
     case INDEX_op_tci_setcond32:
@@ -0,0 +1,171 @@
+/*
+ * fp-test-floatx80.c - check floatx80 hardfloat against soft-fp
+ *
+ * The floatx80 arithmetic only uses the host FPU when the inexact flag
+ * is already set, so run every operation twice, once with inexact set
+ * and once without, and require identical results and exceptions.
+ * This is done both for the x87 and for the m68k flavour of floatx80.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+#ifndef HW_POISON_H
+#error Must define HW_POISON_H to work around TARGET_* poisoning
+#endif
+
+#include "qemu/osdep.h"
+#include "fpu/softfloat.h"
+
+typedef floatx80 (*op2_fn)(floatx80 a, floatx80 b, float_status *s);
+
+static const struct {
+    const char *name;
+    op2_fn fn;
+} ops[] = {
+    { "add", floatx80_add },
+    { "sub", floatx80_sub },
+    { "mul", floatx80_mul },
+    { "div", floatx80_div },
+};
+
+static const struct {
+    const char *name;
+    FloatX80RoundPrec prec;
+} precs[] = {
+    { "x", floatx80_precision_x },
+    { "d", floatx80_precision_d },
+    { "s", floatx80_precision_s },
+};
+
+static const struct {
+    const char *name;
+    FloatX80Behaviour behaviour;
+} behaviours[] = {
+    { "x87", 0 },
+    { "m68k", floatx80_default_inf_int_bit_is_zero |
+              floatx80_pseudo_inf_valid |
+              floatx80_pseudo_nan_valid |
+              floatx80_unnormal_valid |
+              floatx80_pseudo_denormal_valid },
+};
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+static int errors;
+
+static uint64_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/*
+ * Mostly normal numbers, with exponents close to the limits of both
+ * floatx80 and double so that overflow and underflow get exercised,
+ * and with a share of values that are exact doubles.
+ */
+static floatx80 random_fx80(void)
+{
+    static const int exps[] = {
+        0x3fff, 0x3fff + 60, 0x3fff - 60,
+        0x3fff + 1023, 0x3fff - 1022,
+        0x7ffe, 0x0001, 0x4000 + 8000, 0x3fff - 8000,
+    };
+    uint64_t r = rng();
+    uint64_t low = rng() | (1ull << 63);
+    int exp = exps[r % ARRAY_SIZE(exps)] + (int)((r >> 8) % 5) - 2;
+
+    exp = MIN(MAX(exp, 1), 0x7ffe);
+    if (r & (1 << 16)) {
+        low &= ~0x7ffull;
+    }
+    if ((r >> 17) % 32 == 0) {
+        return make_floatx80((r >> 22) & 1 ? 0x8000 : 0, 0);
+    }
+    return make_floatx80(exp | ((r >> 23) & 1 ? 0x8000 : 0), low);
+}
+
+static void init_status(float_status *s, FloatX80RoundPrec prec,
+                        FloatX80Behaviour behaviour)
+{
+    memset(s, 0, sizeof(*s));
+    set_float_rounding_mode(float_round_nearest_even, s);
+    set_floatx80_rounding_precision(prec, s);
+    set_floatx80_behaviour(behaviour, s);
+    set_float_2nan_prop_rule(float_2nan_prop_x87, s);
+    set_float_default_nan_pattern(0b11000000, s);
+    set_float_ftz_detection(float_ftz_after_rounding, s);
+}
+
+static void report(const char *op, const char *prec, const char *behaviour,
+                   floatx80 a, floatx80 b,
+                   floatx80 soft, int soft_flags,
+                   floatx80 hard, int hard_flags)
+{
+    printf("%s/%s/%s: %04x:%016" PRIx64 " %04x:%016" PRIx64 "\n"
+           "  soft: %04x:%016" PRIx64 " flags 0x%x\n"
+           "  hard: %04x:%016" PRIx64 " flags 0x%x\n",
+           op, prec, behaviour, a.high, a.low, b.high, b.low,
+           soft.high, soft.low, soft_flags, hard.high, hard.low, hard_flags);
+    if (++errors == 20) {
+        exit(1);
+    }
+}
+
+static void check(const char *op, const char *prec, const char *behaviour,
+                  floatx80 a, floatx80 b, floatx80 soft, float_status *ss,
+                  floatx80 hard, float_status *hs)
+{
+    /* The hardfloat run starts with inexact set; ignore it in both. */
+    int soft_flags = ss->float_exception_flags | float_flag_inexact;
+    int hard_flags = hs->float_exception_flags;
+
+    if (soft.high != hard.high || soft.low != hard.low ||
+        soft_flags != hard_flags) {
+        report(op, prec, behaviour, a, b, soft, soft_flags, hard, hard_flags);
+    }
+}
+
+int main(int ac, char **av)
+{
+    float_status ss, hs;
+    floatx80 a, b, soft, hard;
+    int i, j, k, m;
+
+    for (i = 0; i < 200000; ++i) {
+        a = random_fx80();
+        b = random_fx80();
+        if (i % 64 == 0) {
+            b = floatx80_chs(a);
+        }
+
+        for (m = 0; m < ARRAY_SIZE(behaviours); ++m) {
+            FloatX80Behaviour bh = behaviours[m].behaviour;
+            const char *bname = behaviours[m].name;
+
+            for (j = 0; j < ARRAY_SIZE(precs); ++j) {
+                for (k = 0; k < ARRAY_SIZE(ops); ++k) {
+                    init_status(&ss, precs[j].prec, bh);
+                    init_status(&hs, precs[j].prec, bh);
+                    hs.float_exception_flags = float_flag_inexact;
+
+                    soft = ops[k].fn(a, b, &ss);
+                    hard = ops[k].fn(a, b, &hs);
+                    check(ops[k].name, precs[j].name, bname,
+                          a, b, soft, &ss, hard, &hs);
+                }
+
+                init_status(&ss, precs[j].prec, bh);
+                init_status(&hs, precs[j].prec, bh);
+                hs.float_exception_flags = float_flag_inexact;
+
+                soft = floatx80_sqrt(a, &ss);
+                hard = floatx80_sqrt(a, &hs);
+                check("sqrt", precs[j].name, bname,
+                      a, a, soft, &ss, hard, &hs);
+            }
+        }
+    }
+
+    return errors != 0;
+}
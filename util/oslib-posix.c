@@ -610,20 +610,25 @@ static bool madv_populate_write_possible(char *area, size_t pagesize)
            errno != EINVAL;
 }
 
-bool qemu_prealloc_mem(int fd, char *area, size_t sz, int max_threads,
-                       ThreadContext *tc, bool async, Error **errp)
+static size_t prealloc_pagesize(int fd)
 {
-    static gsize initialized;
-    int ret;
 #ifndef EMSCRIPTEN
-    size_t hpagesize = qemu_fd_getpagesize(fd);
+    return qemu_fd_getpagesize(fd);
 #else
     /*
      * mmap-alloc.c is excluded from Emscripten build, so qemu_fd_getpagesize
      * is unavailable. Fallback to the lower level implementation.
      */
-    size_t hpagesize = qemu_real_host_page_size();
+    return qemu_real_host_page_size();
 #endif
+}
+
+bool qemu_prealloc_mem(int fd, char *area, size_t sz, int max_threads,
+                       ThreadContext *tc, bool async, Error **errp)
+{
+    static gsize initialized;
+    int ret;
+    size_t hpagesize = prealloc_pagesize(fd);
     size_t numpages = DIV_ROUND_UP(sz, hpagesize);
     bool use_madv_populate_write;
     struct sigaction act;
@@ -681,6 +686,110 @@ bool qemu_prealloc_mem(int fd, char *area, size_t sz, int max_threads,
     return rv;
 }
 
+/* Background preallocation hands out chunks of this size, in address order. */
+#define MEM_PREALLOC_JOB_CHUNK (16 * MiB)
+
+struct MemPreallocJob {
+    char *area;
+    size_t size;
+    size_t chunk;
+    /* Offset of the next chunk to populate; size once the job is stopped. */
+    size_t next;
+    /* Bytes populated so far. */
+    size_t done;
+    int num_threads;
+    QemuThread *threads;
+};
+
+static void *do_prealloc_job(void *arg)
+{
+    MemPreallocJob *job = arg;
+    size_t offset;
+
+    /*
+     * Guests usually start using memory from the bottom, so handing out
+     * chunks in ascending order keeps the populated area ahead of them.
+     * Whatever the guest touches first is faulted in on demand anyway.
+     */
+    while ((offset = qatomic_fetch_add(&job->next, job->chunk)) < job->size) {
+        size_t len = MIN(job->chunk, job->size - offset);
+
+        if (qemu_madvise(job->area + offset, len, QEMU_MADV_POPULATE_WRITE)) {
+            warn_report("background preallocation failed at offset 0x%zx: %s",
+                        offset, strerror(errno));
+            qatomic_set(&job->next, job->size);
+            break;
+        }
+        qatomic_add(&job->done, len);
+    }
+    return NULL;
+}
+
+bool qemu_prealloc_mem_background(int fd, char *area, size_t sz,
+                                  int max_threads, ThreadContext *tc,
+                                  MemPreallocJob **jobp, Error **errp)
+{
+    size_t hpagesize = prealloc_pagesize(fd);
+    size_t numpages = DIV_ROUND_UP(sz, hpagesize);
+    MemPreallocJob *job;
+    int i;
+
+    *jobp = NULL;
+
+    /*
+     * The guest runs while the area is being populated, so the read and
+     * write back done by touch_all_pages() without MADV_POPULATE_WRITE
+     * could undo guest writes.  Preallocate synchronously instead.
+     */
+    if (!madv_populate_write_possible(area, hpagesize)) {
+        return qemu_prealloc_mem(fd, area, sz, max_threads, tc, false, errp);
+    }
+
+    job = g_new0(MemPreallocJob, 1);
+    job->area = area;
+    job->size = numpages * hpagesize;
+    job->chunk = QEMU_ALIGN_UP(MEM_PREALLOC_JOB_CHUNK, hpagesize);
+    job->num_threads = get_memset_num_threads(hpagesize, numpages,
+                                              max_threads);
+    job->threads = g_new0(QemuThread, job->num_threads);
+
+    for (i = 0; i < job->num_threads; i++) {
+        if (tc) {
+            thread_context_create_thread(tc, &job->threads[i], "prealloc_bg",
+                                         do_prealloc_job, job,
+                                         QEMU_THREAD_JOINABLE);
+        } else {
+            qemu_thread_create(&job->threads[i], "prealloc_bg",
+                               do_prealloc_job, job, QEMU_THREAD_JOINABLE);
+        }
+    }
+
+    *jobp = job;
+    return true;
+}
+
+size_t qemu_prealloc_job_done(MemPreallocJob *job)
+{
+    return qatomic_read(&job->done);
+}
+
+void qemu_prealloc_job_free(MemPreallocJob *job)
+{
+    int i;
+
+    if (!job) {
+        return;
+    }
+
+    /* Threads finish the chunk they are working on, then exit. */
+    qatomic_set(&job->next, job->size);
+    for (i = 0; i < job->num_threads; i++) {
+        qemu_thread_join(&job->threads[i]);
+    }
+    g_free(job->threads);
+    g_free(job);
+}
+
 char *qemu_get_pid_name(pid_t pid)
 {
     char *name = NULL;
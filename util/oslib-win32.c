@@ -285,6 +285,25 @@ bool qemu_finish_async_prealloc_mem(Error **errp)
     return true;
 }
 
+bool qemu_prealloc_mem_background(int fd, char *area, size_t sz,
+                                  int max_threads, ThreadContext *tc,
+                                  MemPreallocJob **jobp, Error **errp)
+{
+    /* background prealloc not supported, preallocate synchronously */
+    *jobp = NULL;
+    return qemu_prealloc_mem(fd, area, sz, max_threads, tc, false, errp);
+}
+
+size_t qemu_prealloc_job_done(MemPreallocJob *job)
+{
+    g_assert_not_reached();
+}
+
+void qemu_prealloc_job_free(MemPreallocJob *job)
+{
+    assert(!job);
+}
+
 char *qemu_get_pid_name(pid_t pid)
 {
     /* XXX Implement me */